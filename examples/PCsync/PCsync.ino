@@ -14,6 +14,9 @@
  * RTC chip rather than using this script.  An example of that type of script is available on Sodaq's
  * website.
  *
+ * The sketch also answers the binary sync frames of PCsyncBinary.py (see Sodaq_TimeSync.h), which
+ * measures the serial delay and sets the clock on a seconds boundary to within a few milliseconds.
+ *
  * This script requires the wire library generally built into the Arduino IDE and the Sodaq DS3231
  * library, linked below.
  *
@@ -21,6 +24,9 @@
 
 #include <Wire.h>  //http://arduino.cc/en/Reference/Wire (included with Arduino IDE)
 #include <Sodaq_DS3231.h> //Sodaq's library for the DS3231: https://github.com/SodaqMoja/Sodaq_DS3231
+#include <Sodaq_TimeSync.h>
+
+TimeSyncResponder timeSync(rtc, Serial);
 
 String getDateTime()
 {
@@ -39,23 +45,63 @@ String getDateTime()
 /*  code to process time sync messages from the serial port   */
 #define TIME_HEADER  'T'   // Header tag for serial time sync message
 
-unsigned long processSyncMessage() {
-  unsigned long pctime = 0L;
-  const unsigned long DEFAULT_TIME = 1451606400; // Jan 1 2016 00:00:00.000
-  const unsigned long MAX_TIME = 2713910400; // Jan 1 2056 00:00:00.000
+#define FIRST_DIGIT_MS  1000  // Wait for the first digit, as Stream's default timeout
+#define DIGIT_GAP_MS    20    // The time stamp ends when no digit follows within this
+
+// The next character without taking it, or -1 if none arrives within ms
+int peekWithin(uint32_t ms) {
+  uint32_t start = millis();
+  while (!Serial.available()) {
+    if (millis() - start >= ms)
+      return -1;
+  }
+  return Serial.peek();
+}
+
+// Serial.parseInt() returns a 32-bit long that overflows in 2038, so read
+// the digits of the time stamp into 64 bits instead. Digits are taken one
+// at a time, so the read ends with the time stamp rather than a timeout,
+// and of what follows only a line ending is consumed: a binary sync frame
+// right behind it is left for TimeSyncResponder.
+epoch64_t parseEpoch64() {
+  epoch64_t val = 0;
+  uint8_t len = 0;
+  int c = -1;
+  while (len < 19) {
+    c = peekWithin(len ? DIGIT_GAP_MS : FIRST_DIGIT_MS);
+    if (c < '0' || c > '9')
+      break;
+    val = val * 10 + (Serial.read() - '0');
+    len++;
+  }
+  if (c == '\r') {
+    Serial.read();
+    c = peekWithin(DIGIT_GAP_MS);
+  }
+  if (c == '\n')
+    Serial.read();
+  return val;
+}
+
+epoch64_t processSyncMessage() {
+  epoch64_t pctime = 0;
+  const epoch64_t DEFAULT_TIME = 1451606400; // Jan 1 2016 00:00:00.000
+  const epoch64_t MAX_TIME = 9025257599LL; // Dec 31 2255 23:59:59, the last DateTime
 
   if (Serial.find(TIME_HEADER)) {
-    pctime = Serial.parseInt();
-    Serial.println("Received:" + String(pctime));
+    pctime = parseEpoch64();
+    Serial.print("Received:");
+    DateTime::fromEpoch64(pctime).printTo(Serial);
+    Serial.println();
     if ( pctime < DEFAULT_TIME) // check the value is a valid time (greater than Jan 1 2016)
     {
       Serial.println("Time out of range");
-      pctime = 0L; // return 0 to indicate that the time is not valid
+      pctime = 0; // return 0 to indicate that the time is not valid
     }
-    if ( pctime > MAX_TIME) // check the value is a valid time (greater than Jan 1 2016)
+    if ( pctime > MAX_TIME) // check the value is a valid time (up to the end of 2255)
     {
       Serial.println("Time out of range");
-      pctime = 0L; // return 0 to indicate that the time is not valid
+      pctime = 0; // return 0 to indicate that the time is not valid
     }
   }
   return pctime;
@@ -65,7 +111,7 @@ unsigned long processSyncMessage() {
 void syncRTCwithBatch()
 {
   // Read the timestamp from the PC's batch program
-  uint32_t newTs = processSyncMessage();
+  epoch64_t newTs = processSyncMessage();
 
   if (newTs > 0)
   {
@@ -76,17 +122,21 @@ void syncRTCwithBatch()
     //newTs += SYNC_DELAY + TIME_ZONE_SEC;
 
     //Get the old time stamp and print out difference in times
-    uint32_t oldTs = rtc.now().getEpoch();
-    int32_t diffTs = newTs - oldTs;
-    int32_t diffTs_abs = abs(diffTs);
+    DateTime oldDt = rtc.now();
+    DateTime newDt = DateTime::fromEpoch64(newTs);
+    epoch64_t diffTs = newTs - oldDt.getEpoch64();
+    uint32_t diffTs_abs = diffTs < 0 ? -diffTs : diffTs;
     Serial.println("RTC is Off by " + String(diffTs_abs) + " seconds");
 
     //Display old and new time stamps
-    Serial.print("Updating RTC, old = " + String(oldTs));
-    Serial.println(" new = " + String(newTs));
-
-    //Update the rtc
-    rtc.setEpoch(newTs);
+    Serial.print("Updating RTC, old = ");
+    oldDt.printTo(Serial);
+    Serial.print(" new = ");
+    newDt.printTo(Serial);
+    Serial.println();
+
+    //Update the rtc, the century bit is set past 2099
+    rtc.setDateTime(newDt);
   }
 }
 
@@ -114,7 +164,7 @@ String add02d(uint16_t val)
 }
 
 
-void loop()
+void printDateTime()
 {
   //Print out current date/time
   DateTime now = rtc.now(); //get the current date-time
@@ -134,17 +184,31 @@ void loop()
   Serial.print(':');
   Serial.print(add02d(now.second()));
   Serial.println(" (" + String(ts) + ")");
+}
+
 
-  if (Serial.available())
+uint32_t lastPrintMs = 0;
+
+void loop()
+{
+  // Text commands first, poll() drops whatever isn't a binary sync frame
+  if (Serial.available() && Serial.peek() != TSYNC_SOF)
   {
     //Sync time
     syncRTCwithBatch();
+    // Empty the serial buffer
+    while (Serial.available() > 0 && Serial.peek() != TSYNC_SOF)
+    {
+      Serial.read();
+    }
   }
-  // Empty the serial buffer
-  while (Serial.available() > 0)
+
+  // Binary sync frames are timestamped on arrival, so poll without delays
+  timeSync.poll();
+
+  if (millis() - lastPrintMs >= 1000)
   {
-    Serial.read();
+    lastPrintMs = millis();
+    printDateTime();
   }
-
-  delay(1000);
 }
@@ -0,0 +1,367 @@
+# -*- coding: utf-8 -*-
+
+"""
+Sets the DS3231 on a device running PCsync.ino to within a few milliseconds
+of NTP or local PC time, using the framed binary protocol of
+Sodaq_TimeSync.h instead of the text "T<epoch>" command.
+
+ - PING exchanges give four timestamps each (host send, device receive,
+   device send, host receive). The offset of the device micros() clock is
+   ((t2 - t1) + (t3 - t4)) / 2 and the round trip delay is
+   (t4 - t1) - (t3 - t2). A line is fitted through the offsets of the
+   fastest exchanges, which also gives the micros() rate error.
+ - SET asks the device to write the RTC at the micros() value where host
+   time reaches the next whole second plus one. The DS3231 starts the new
+   second when the seconds register is written.
+ - READ returns the micros() at which the RTC started its next second,
+   so the result is measured rather than assumed.
+
+Usage:
+    python PCsyncBinary.py                  # first FTDI port, NTP if reachable
+    python PCsyncBinary.py --port /dev/ttyUSB0 --no-ntp
+    python PCsyncBinary.py --emulate        # emulated device on a pty pair
+
+With an FTDI adapter on Linux, lowering the latency timer from its 16 ms
+default gives faster exchanges to choose from:
+    echo 1 > /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
+"""
+
+import argparse
+import binascii
+import math
+import os
+import random
+import select
+import struct
+import sys
+import threading
+import time
+
+SOF = 0xA5
+PAYLOAD_LEN = 16
+FRAME_LEN = 3 + PAYLOAD_LEN + 2
+
+PING, SET, READ, REPLY = 0x01, 0x02, 0x03, 0x80
+STATUS_TEXT = {0: "ok", 1: "write time had passed", 2: "write time too far ahead"}
+
+
+def crc16(data):
+    # CRC-16/CCITT-FALSE, as TimeSyncResponder::crc16()
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def encode_frame(frame_type, payload):
+    body = bytes([frame_type, PAYLOAD_LEN]) + payload.ljust(PAYLOAD_LEN, b"\0")
+    return bytes([SOF]) + body + struct.pack(">H", crc16(body))
+
+
+class FdPort:
+    # A raw file descriptor, e.g. one end of a pty pair
+    def __init__(self, fd):
+        self.fd = fd
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def read(self, timeout):
+        ready, _, _ = select.select([self.fd], [], [], timeout)
+        return os.read(self.fd, 256) if ready else b""
+
+    def close(self):
+        os.close(self.fd)
+
+
+class SerialPort:
+    def __init__(self, device, baud):
+        import serial  # pyserial, only needed for real ports
+        self.ser = serial.Serial(device, baud, timeout=0)
+
+    def write(self, data):
+        self.ser.write(data)
+
+    def read(self, timeout):
+        ready, _, _ = select.select([self.ser.fileno()], [], [], timeout)
+        return self.ser.read(256) if ready else b""
+
+    def close(self):
+        self.ser.close()
+
+
+class FrameReader:
+    # Splits the byte stream into frames, printing any text the sketch sends
+    def __init__(self, port, verbose=False):
+        self.port = port
+        self.buf = bytearray()
+        self.verbose = verbose
+
+    def next_frame(self, timeout):
+        deadline = time.monotonic() + timeout
+        while True:
+            frame = self._take()
+            if frame is not None:
+                return frame
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            self.buf += self.port.read(left)
+
+    def _take(self):
+        while self.buf:
+            start = self.buf.find(SOF)
+            text = self.buf if start < 0 else self.buf[:start]
+            if text and self.verbose:
+                sys.stdout.write(text.decode(errors="replace"))
+            if start < 0:
+                self.buf.clear()
+                return None
+            del self.buf[:start]
+            if len(self.buf) < FRAME_LEN:
+                return None
+            frame = bytes(self.buf[:FRAME_LEN])
+            body = frame[1:-2]
+            if body[1] == PAYLOAD_LEN and struct.unpack(">H", frame[-2:])[0] == crc16(body):
+                del self.buf[:FRAME_LEN]
+                return body[0], body[2:]
+            del self.buf[:1]  # Not a frame after all
+        return None
+
+
+class HostClock:
+    # Host time in microseconds since the Unix epoch, corrected by NTP when available
+    def __init__(self, use_ntp):
+        self.offset_us = 0
+        self.source = "local computer time"
+        if use_ntp:
+            try:
+                import ntplib
+                response = ntplib.NTPClient().request("us.pool.ntp.org", version=3)
+                self.offset_us = int(response.offset * 1e6)
+                self.source = "Network Time Protocol server us.pool.ntp.org"
+            except Exception:
+                pass
+
+    def now_us(self):
+        return time.time_ns() // 1000 + self.offset_us
+
+
+class Unwrapper:
+    # Extends the 32-bit device micros() to a monotonic count
+    def __init__(self):
+        self.last = None
+        self.high = 0
+
+    def __call__(self, value):
+        if self.last is not None and value < self.last and self.last - value > 1 << 31:
+            self.high += 1 << 32
+        self.last = value
+        return self.high + value
+
+
+class TimeSync:
+    def __init__(self, port, clock, verbose=False):
+        self.port = port
+        self.frames = FrameReader(port, verbose)
+        self.clock = clock
+        self.unwrap = Unwrapper()
+        self.samples = []  # (host us, device minus host us, round trip us)
+
+    def request(self, frame_type, payload, timeout=2.0):
+        self.port.write(encode_frame(frame_type, payload))
+        while True:
+            frame = self.frames.next_frame(timeout)
+            if frame is None:
+                raise TimeoutError(f"no reply to request {frame_type:#04x}")
+            if frame[0] == frame_type | REPLY:
+                return frame[1]
+
+    def ping(self):
+        t1 = self.clock.now_us()
+        reply = self.request(PING, struct.pack("<Q", t1))
+        t4 = self.clock.now_us()
+        echo, t2, t3 = struct.unpack("<QII", reply)
+        if echo != t1:
+            return None
+        t2 = self.unwrap(t2)
+        t3 = t2 + ((t3 - t2) & 0xFFFFFFFF)
+        offset = ((t2 - t1) + (t3 - t4)) / 2
+        delay = (t4 - t1) - (t3 - t2)
+        self.samples.append(((t1 + t4) / 2, offset, delay))
+        return offset, delay
+
+    def fit(self):
+        # Least squares line through the faster half of the exchanges:
+        # device micros = host us + a + b * (host us - t0)
+        best = sorted(self.samples, key=lambda s: s[2])[:max(3, len(self.samples) // 2)]
+        t0 = sum(s[0] for s in best) / len(best)
+        o0 = sum(s[1] for s in best) / len(best)
+        stt = sum((s[0] - t0) ** 2 for s in best)
+        b = sum((s[0] - t0) * (s[1] - o0) for s in best) / stt if stt > 0 else 0.0
+        self.t0, self.a, self.b = t0, o0, b
+        return best[0][2], b * 1e6
+
+    def device_at(self, host_us):
+        return host_us + self.a + self.b * (host_us - self.t0)
+
+    def host_at(self, device_us):
+        return (device_us - self.a + self.b * self.t0) / (1 + self.b)
+
+    def measure(self, count, spacing):
+        for _ in range(count):
+            self.ping()
+            time.sleep(spacing * random.uniform(0.5, 1.5))
+        return self.fit()
+
+    def set_clock(self):
+        target = math.ceil(self.clock.now_us() / 1e6 + 1.2)
+        at = int(round(self.device_at(target * 1e6))) & 0xFFFFFFFF
+        reply = self.request(SET, struct.pack("<qI", target, at), timeout=5.0)
+        old_epoch, written, status = struct.unpack("<qIB", reply[:13])
+        return target, old_epoch, status
+
+    def verify(self):
+        reply = self.request(READ, b"", timeout=3.0)
+        epoch, rollover = struct.unpack("<qI", reply[:12])
+        if epoch == 0:
+            return None
+        started = self.host_at(self.unwrap(rollover))
+        return epoch, (started - epoch * 1e6) / 1000.0
+
+
+class EmulatedDevice(threading.Thread):
+    # PCsync.ino with TimeSyncResponder, on the master end of a pty pair.
+    # micros() runs skew_ppm fast from a start near its wrap, replies leave
+    # after a random USB-like latency, and the RTC starts out of step.
+    def __init__(self, fd, skew_ppm, latency_ms):
+        super().__init__(daemon=True)
+        self.port = FdPort(fd)
+        self.skew = skew_ppm * 1e-6
+        self.latency_ms = latency_ms
+        self.base_us = time.time_ns() // 1000
+        self.micros0 = 0xFFFFFFFF - 3000000
+        self.rtc_shift = random.uniform(-30, 30)  # RTC seconds ahead of true time
+        self.running = True
+
+    def true_s(self):
+        return time.time_ns() / 1e9
+
+    def micros(self):
+        elapsed = time.time_ns() // 1000 - self.base_us
+        return int(self.micros0 + elapsed * (1 + self.skew)) & 0xFFFFFFFF
+
+    def rtc_epoch(self):
+        return math.floor(self.true_s() + self.rtc_shift)
+
+    def send(self, frame_type, payload):
+        time.sleep(random.uniform(0, self.latency_ms) / 1000)
+        self.port.write(encode_frame(frame_type | REPLY, payload))
+
+    def run(self):
+        buf = bytearray()
+        next_print = time.monotonic()
+        while self.running:
+            try:
+                buf += self.port.read(0.01)
+            except OSError:
+                return  # Host end closed
+            if time.monotonic() >= next_print:
+                next_print += 1
+                self.port.write(f"Current RTC Date/Time: ({self.rtc_epoch()})\r\n".encode())
+            while len(buf) >= FRAME_LEN:
+                if buf[0] != SOF:
+                    del buf[:1]
+                    continue
+                t2 = self.micros()
+                frame = bytes(buf[:FRAME_LEN])
+                del buf[:FRAME_LEN]
+                if struct.unpack(">H", frame[-2:])[0] == crc16(frame[1:-2]):
+                    self.answer(frame[1], frame[3:-2], t2)
+
+    def answer(self, frame_type, payload, t2):
+        if frame_type == PING:
+            self.send(PING, payload[:8] + struct.pack("<II", t2, self.micros()))
+        elif frame_type == SET:
+            epoch, at = struct.unpack("<qI", payload[:12])
+            old = self.rtc_epoch()
+            wait = ((at - self.micros() + (1 << 31)) & 0xFFFFFFFF) - (1 << 31)
+            status = 1 if wait < 0 else 2 if wait > 3000000 else 0
+            written = 0
+            if status == 0:
+                while 0 < ((at - self.micros()) & 0xFFFFFFFF) < 1 << 31:
+                    pass
+                written = self.micros()
+                self.rtc_shift = epoch - self.true_s()
+            self.send(SET, struct.pack("<qIB", old, written, status))
+        elif frame_type == READ:
+            first = self.rtc_epoch()
+            while self.rtc_epoch() == first:
+                time.sleep(0.0002)
+            self.send(READ, struct.pack("<qI", self.rtc_epoch(), self.micros()))
+
+
+def find_ftdi_port():
+    import serial.tools.list_ports
+    device_ports = [p for p in serial.tools.list_ports.comports() if p.manufacturer == "FTDI"]
+    if not device_ports:
+        sys.exit("No FTDI device found")
+    print(f"FTDI Device found at {device_ports[0].description}")
+    return device_ports[0].device
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--port", help="serial device, default the first FTDI port")
+    parser.add_argument("--baud", type=int, default=57600)
+    parser.add_argument("--samples", type=int, default=16, help="PING exchanges before setting")
+    parser.add_argument("--no-ntp", action="store_true", help="use the local computer clock")
+    parser.add_argument("--verbose", action="store_true", help="show text the sketch prints")
+    parser.add_argument("--emulate", action="store_true", help="talk to an emulated device on a pty pair")
+    parser.add_argument("--skew-ppm", type=float, default=500.0, help="emulated micros() error")
+    parser.add_argument("--latency-ms", type=float, default=4.0, help="emulated reply latency")
+    args = parser.parse_args()
+
+    device = None
+    if args.emulate:
+        import tty
+        master, slave = os.openpty()
+        tty.setraw(master)
+        tty.setraw(slave)
+        device = EmulatedDevice(master, args.skew_ppm, args.latency_ms)
+        device.start()
+        print(f"Emulated device on {os.ttyname(slave)}")
+        port = FdPort(slave)
+        clock = HostClock(False)
+    else:
+        port = SerialPort(args.port or find_ftdi_port(), args.baud)
+        print("Waiting for device to initialize")
+        time.sleep(2)
+        clock = HostClock(not args.no_ntp)
+    print(f"Using {clock.source}")
+
+    sync = TimeSync(port, clock, args.verbose)
+    try:
+        best_delay, ppm = sync.measure(args.samples, 0.1)
+        print(f"Fastest round trip {best_delay / 1000:.2f} ms, device micros() off by {ppm:+.1f} ppm")
+
+        target, old_epoch, status = sync.set_clock()
+        if status:
+            sys.exit(f"Device did not set the clock: {STATUS_TEXT.get(status, status)}")
+        print(f"RTC set to {target} at the start of that second (it read {old_epoch})")
+
+        sync.measure(max(4, args.samples // 2), 0.05)
+        result = sync.verify()
+        if result is None:
+            sys.exit("Device RTC did not tick")
+        epoch, error_ms = result
+        print(f"RTC second {epoch} started {error_ms:+.2f} ms from the host clock")
+        if device is not None:
+            print(f"Emulated RTC second actually started {-device.rtc_shift * 1000:+.2f} ms from the host clock")
+    except TimeoutError as err:
+        sys.exit(f"Device is not answering: {err}. Is PCsync.ino running?")
+    finally:
+        if device is not None:
+            device.running = False
+        port.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+// Microbenchmarks for the DateTime, BCD and formatting hot paths.
+//
+// Each case runs over a table of inputs, either random (fixed seed) or a
+// worst case such as 2099-12-31 23:59:59, and prints one CSV row:
+//
+//   benchmark,inputs,iterations,ns_per_op,ops_per_sec
+//
+// The loop overhead (reading the input, keeping the result) is measured
+// separately and subtracted. Results go to the serial port at 57600 baud,
+// once after reset; capture them and diff against a previous run.
+
+#include <Wire.h>
+#include <Sodaq_DS3231.h>
+#include <Sodaq_RtcBackend.h>
+#include <Sodaq_DateTimeBatch.h>
+
+using namespace sodaq_DS3231_nm;
+
+typedef RtcCodec<Ds3231Chip> Ds3231Codec;
+
+#define BENCH_INPUTS        32
+// Enough iterations for a few hundred milliseconds per case on an AVR
+#define BENCH_ITERATIONS    2048
+
+// xorshift32, so every run sees the same "random" inputs
+static uint32_t rngState = 2463534242UL;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// Inputs are read through volatile so nothing folds at compile time
+static volatile uint32_t inSecs[BENCH_INPUTS];
+static volatile uint8_t inBytes[BENCH_INPUTS];
+static volatile uint16_t inYears[BENCH_INPUTS];
+static volatile uint8_t inMonths[BENCH_INPUTS];
+static volatile uint8_t inDays[BENCH_INPUTS];
+static char inDigits[BENCH_INPUTS][3];
+static DateTime inDates[BENCH_INPUTS];
+static uint8_t inBlocks[BENCH_INPUTS][RTC_TIME_BLOCK_LEN];
+// inSecs again, for the batch conversion, which takes a plain array
+static uint32_t inSecsArray[BENCH_INPUTS];
+static uint16_t outYears[BENCH_INPUTS];
+static uint8_t outMonths[BENCH_INPUTS], outDays[BENCH_INPUTS], outHours[BENCH_INPUTS];
+static uint8_t outMinutes[BENCH_INPUTS], outSeconds[BENCH_INPUTS], outWdays[BENCH_INPUTS];
+static volatile uint32_t sink;
+
+// 2099-12-31 23:59:59, the last second of the DS3231 two-digit year
+static const uint32_t WORST_Y2K = DateTime(2099, 12, 31, 23, 59, 59, 5).get();
+
+enum InputKind { RANDOM, WORST };
+
+static void fillInputs(InputKind kind)
+{
+    for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+        uint32_t secs = kind == WORST ? WORST_Y2K : rng() % (WORST_Y2K + 1);
+        DateTime dt(secs);
+        inSecs[i] = secs;
+        inSecsArray[i] = secs;
+        inDates[i] = dt;
+        inYears[i] = dt.year();
+        inMonths[i] = dt.month();
+        inDays[i] = dt.date();
+        Ds3231Codec::encodeBytewise(dt, inBlocks[i]);
+        uint8_t byte = kind == WORST ? 99 : rng() % 100;
+        inBytes[i] = byte;
+        inDigits[i][0] = '0' + byte / 10;
+        inDigits[i][1] = '0' + byte % 10;
+        inDigits[i][2] = 0;
+    }
+}
+
+typedef void (*BenchFn)(uint8_t i);
+
+static uint32_t timeLoop(BenchFn fn)
+{
+    uint32_t start = micros();
+    for (uint16_t n = 0; n < BENCH_ITERATIONS; n++)
+        fn(n % BENCH_INPUTS);
+    return micros() - start;
+}
+
+static void benchNothing(uint8_t i) { sink += inSecs[i]; }
+
+static void report(const char *name, InputKind kind, BenchFn fn)
+{
+    uint32_t overheadUs = timeLoop(benchNothing);
+    uint32_t us = timeLoop(fn);
+    uint32_t netUs = us > overheadUs ? us - overheadUs : 0;
+    uint32_t nsPerOp = (uint32_t)((uint64_t)netUs * 1000 / BENCH_ITERATIONS);
+
+    Serial.print(name);
+    Serial.print(kind == WORST ? F(",worst,") : F(",random,"));
+    Serial.print(BENCH_ITERATIONS);
+    Serial.print(',');
+    Serial.print(nsPerOp);
+    Serial.print(',');
+    Serial.println(nsPerOp ? 1000000000UL / nsPerOp : 0);
+}
+
+static void benchDateTimeLong(uint8_t i) { sink += DateTime((long)inSecs[i]).date(); }
+static void benchGet(uint8_t i) { sink += inDates[i].get(); }
+static void benchDate2days(uint8_t i) { sink += DateTime::date2days(inYears[i], inMonths[i], inDays[i]); }
+static void benchDayOfWeek(uint8_t i) { sink += DateTime::DayOfWeek(inYears[i], inMonths[i], inDays[i]); }
+static void benchBcd2bin(uint8_t i) { sink += bcd2bin(inBytes[i]); }
+static void benchBin2bcd(uint8_t i) { sink += bin2bcd(inBytes[i]); }
+static void benchConv2d(uint8_t i) { sink += DateTime::conv2d(inDigits[i]); }
+// Doubling the input reaches past 2136, where the 64 bit path takes over
+static void benchFromEpoch64(uint8_t i)
+{
+    sink += DateTime::fromEpoch64((epoch64_t)inSecs[i] * 2 + EPOCH_TIME_OFF).date();
+}
+
+// The whole seconds..year block, as read by now(), with its range check
+static void benchDecode(uint8_t i)
+{
+    DateTime dt;
+    sink += Ds3231Codec::decode(inBlocks[i], dt) + dt.date();
+}
+
+static void benchDecodeBytewise(uint8_t i)
+{
+    sink += Ds3231Codec::validBytewise(inBlocks[i]) + Ds3231Codec::decodeBytewise(inBlocks[i]).date();
+}
+
+static void benchEncode(uint8_t i)
+{
+    uint8_t buf[RTC_TIME_BLOCK_LEN];
+    Ds3231Codec::encode(inDates[i], buf);
+    sink += buf[0];
+}
+
+static void benchEncodeBytewise(uint8_t i)
+{
+    uint8_t buf[RTC_TIME_BLOCK_LEN];
+    Ds3231Codec::encodeBytewise(inDates[i], buf);
+    sink += buf[0];
+}
+
+// All inputs at once on every BENCH_INPUTS-th call, so ns_per_op is per
+// element and compares with DateTime(long)
+static void benchBatchFromY2k(uint8_t i)
+{
+    if (i)
+        return;
+    DateTimeColumns cols = { outYears, outMonths, outDays, outHours, outMinutes, outSeconds, outWdays };
+    DateTimeBatch::fromY2k(inSecsArray, BENCH_INPUTS, cols);
+    sink += outDays[BENCH_INPUTS - 1];
+}
+
+static void benchFormat(uint8_t i)
+{
+    char buf[DT_FMT_MAX_LEN + 1];
+    sink += inDates[i].format(buf, sizeof(buf));
+}
+
+static void benchAddToString(uint8_t i)
+{
+    String str;
+    inDates[i].addToString(str);
+    sink += str.length();
+}
+
+static void runAll(InputKind kind)
+{
+    fillInputs(kind);
+    report("DateTime(long)", kind, benchDateTimeLong);
+    report("DateTimeBatch::fromY2k", kind, benchBatchFromY2k);
+    report("get", kind, benchGet);
+    report("date2days", kind, benchDate2days);
+    report("DayOfWeek", kind, benchDayOfWeek);
+    report("bcd2bin", kind, benchBcd2bin);
+    report("bin2bcd", kind, benchBin2bcd);
+    report("conv2d", kind, benchConv2d);
+    report("RtcCodec::decode", kind, benchDecode);
+    report("RtcCodec::decodeBytewise", kind, benchDecodeBytewise);
+    report("RtcCodec::encode", kind, benchEncode);
+    report("RtcCodec::encodeBytewise", kind, benchEncodeBytewise);
+    report("fromEpoch64", kind, benchFromEpoch64);
+    report("format", kind, benchFormat);
+    report("addToString", kind, benchAddToString);
+}
+
+void setup()
+{
+    Serial.begin(57600);
+    while (!Serial)
+        ;
+    Serial.println(F("benchmark,inputs,iterations,ns_per_op,ops_per_sec"));
+    runAll(RANDOM);
+    runAll(WORST);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,65 @@
+#include "SimDs3231Bus.h"
+#include <Sodaq_DS3231.h>
+
+// 2024-01-05 01:02:03 Friday, control and status at their power-on values
+uint8_t SimDs3231Bus::regs[SIM_DS3231_REG_COUNT] = {
+    0x03, 0x02, 0x01, 0x06, 0x05, 0x01, 0x24,
+    0, 0, 0, 0, 0, 0, 0,
+    0x1C, 0x88, 0, 0x19, 0x40,
+};
+uint8_t SimDs3231Bus::_ptr;
+uint8_t SimDs3231Bus::_rxLeft;
+bool SimDs3231Bus::_ack;
+bool SimDs3231Bus::_havePtr;
+
+void SimDs3231Bus::beginTransmission(uint8_t address)
+{
+    _ack = address == DS3231_ADDRESS;
+    _havePtr = false;
+}
+
+size_t SimDs3231Bus::write(uint8_t value)
+{
+    if (!_ack)
+        return 0;
+    if (!_havePtr) {
+        _ptr = value < SIM_DS3231_REG_COUNT ? value : 0;
+        _havePtr = true;
+        return 1;
+    }
+    if (_ptr == 0x0F) {
+        // A1F and A2F only clear when written 0
+        regs[_ptr] = (value & 0xFC) | (regs[_ptr] & value & 0x03);
+    } else if (_ptr < 0x11) {
+        regs[_ptr] = value;     // The temperature is read only
+    }
+    next();
+    return 1;
+}
+
+uint8_t SimDs3231Bus::endTransmission()
+{
+    return _ack ? 0 : 2;        // 2: NACK on the address, as TwoWire
+}
+
+uint8_t SimDs3231Bus::requestFrom(uint8_t address, uint8_t len)
+{
+    _rxLeft = address == DS3231_ADDRESS ? len : 0;
+    return _rxLeft;
+}
+
+int SimDs3231Bus::read()
+{
+    if (!_rxLeft)
+        return -1;
+    _rxLeft--;
+    uint8_t value = regs[_ptr];
+    next();
+    return value;
+}
+
+void SimDs3231Bus::next()
+{
+    if (++_ptr == SIM_DS3231_REG_COUNT)
+        _ptr = 0;
+}
@@ -0,0 +1,252 @@
+// Cycle counts and stack use of the main driver calls on an AVR.
+//
+// Meant for simavr (see ReadMe.md), but runs the same on a real ATmega.
+// The driver talks to SimDs3231Bus, a DS3231 register file in RAM, so the
+// numbers are the driver's own cost without the I2C transfer time.
+//
+// Timer1 runs at the CPU clock and counts cycles; the millis() interrupt
+// is stopped while measuring. Each case runs over a table of inputs and
+// prints one CSV row:
+//
+//   benchmark,cycles_min,cycles_avg,cycles_max,us_avg,stack_bytes
+//
+// The cost of the empty call is subtracted. stack_bytes is the deepest the
+// call went below the caller's stack pointer. Flash per function is listed
+// by size_report.py after the build. When done the sketch sleeps with
+// interrupts off, which ends simavr.
+
+#if !defined(__AVR__)
+#error "This benchmark counts cycles with the AVR Timer1"
+#endif
+
+#include <avr/sleep.h>
+#include <Sodaq_DS3231_impl.h>
+#include "SimDs3231Bus.h"
+
+using namespace sodaq_DS3231_nm;
+
+#define BENCH_INPUTS    32
+// Free RAM left unpainted above the heap, for the String in addToString()
+#define STACK_HEAP_GAP  128
+#define STACK_PAINT     0xC5
+
+static Sodaq_DS3231T<SimDs3231Bus> simRtc;
+typedef RtcCodec<Ds3231Chip> Ds3231Codec;
+
+// xorshift32, so every run sees the same "random" inputs
+static uint32_t rngState = 2463534242UL;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static volatile uint32_t inSecs[BENCH_INPUTS];
+static volatile uint8_t inHours[BENCH_INPUTS];
+static volatile uint8_t inMinutes[BENCH_INPUTS];
+static DateTime inDates[BENCH_INPUTS];
+static uint8_t inBlocks[BENCH_INPUTS][RTC_TIME_BLOCK_LEN];
+static volatile uint32_t sink;
+
+static void fillInputs()
+{
+    for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+        // Up to 2099-12-31 23:59:59, the DS3231 two-digit year range
+        inSecs[i] = rng() % 3155760000UL;
+        inDates[i] = DateTime(inSecs[i]);
+        Ds3231Codec::encodeBytewise(inDates[i], inBlocks[i]);
+        inHours[i] = rng() % 24;
+        inMinutes[i] = rng() % 60;
+    }
+}
+
+static volatile uint16_t t1Overflows;
+
+ISR(TIMER1_OVF_vect)
+{
+    t1Overflows++;
+}
+
+static uint32_t cycles()
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t lo = TCNT1;
+    uint16_t hi = t1Overflows;
+    // An overflow still pending since interrupts went off
+    if ((TIFR1 & _BV(TOV1)) && lo < 0x8000)
+        hi++;
+    SREG = sreg;
+    return ((uint32_t)hi << 16) | lo;
+}
+
+static void startCycleCounter()
+{
+    TCCR1A = 0;             // Normal mode, the core sets up PWM
+    TCCR1B = _BV(CS10);     // CPU clock, no prescaler
+    TIMSK1 = _BV(TOIE1);
+    TIMSK0 &= ~_BV(TOIE0);  // Stop millis()
+}
+
+static void stopCycleCounter()
+{
+    TIMSK1 = 0;
+    TIMSK0 |= _BV(TOIE0);
+}
+
+typedef void (*BenchFn)(uint8_t i);
+
+extern char __heap_start;
+extern char *__brkval;
+
+// Paint the free RAM between the heap and the stack pointer, make the
+// call, then find the deepest byte it changed. Interrupts are off, so
+// nothing else writes below the stack pointer meanwhile.
+static uint16_t stackUse(BenchFn fn, uint8_t i)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t *sp = (uint8_t *)SP;
+    uint8_t *bottom = (uint8_t *)(__brkval ? __brkval : &__heap_start) + STACK_HEAP_GAP;
+    for (uint8_t *p = bottom; p < sp; p++)
+        *p = STACK_PAINT;
+    fn(i);
+    uint8_t *p = bottom;
+    while (p < sp && *p == STACK_PAINT)
+        p++;
+    SREG = sreg;
+    return sp - p;
+}
+
+static void benchNothing(uint8_t i) { sink += i; }
+
+static void report(const char *name, BenchFn fn)
+{
+    uint32_t overhead = 0xFFFFFFFF;
+    for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+        uint32_t start = cycles();
+        benchNothing(i);
+        uint32_t spent = cycles() - start;
+        if (spent < overhead)
+            overhead = spent;
+    }
+
+    uint32_t minCycles = 0xFFFFFFFF;
+    uint32_t maxCycles = 0;
+    uint32_t total = 0;
+    uint16_t stack = 0;
+    for (uint8_t i = 0; i < BENCH_INPUTS; i++) {
+        uint32_t start = cycles();
+        fn(i);
+        uint32_t spent = cycles() - start - overhead;
+        total += spent;
+        if (spent < minCycles)
+            minCycles = spent;
+        if (spent > maxCycles)
+            maxCycles = spent;
+
+        uint16_t used = stackUse(fn, i);
+        if (used > stack)
+            stack = used;
+    }
+    uint32_t avg = total / BENCH_INPUTS;
+
+    stopCycleCounter();
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print(minCycles);
+    Serial.print(',');
+    Serial.print(avg);
+    Serial.print(',');
+    Serial.print(maxCycles);
+    Serial.print(',');
+    Serial.print((float)avg / (F_CPU / 1000000UL), 1);
+    Serial.print(',');
+    Serial.println(stack);
+    Serial.flush();
+    startCycleCounter();
+}
+
+static void benchNow(uint8_t) { sink += simRtc.now().get(); }
+static void benchSetEpoch(uint8_t i) { simRtc.setEpoch(inSecs[i] + EPOCH_TIME_OFF); }
+static void benchDateTimeLong(uint8_t i) { sink += DateTime((long)inSecs[i]).date(); }
+
+static void benchEnableInterruptsPeriodic(uint8_t i)
+{
+    simRtc.enableInterrupts(EverySecond + i % 3);
+}
+
+static void benchEnableInterruptsDaily(uint8_t i)
+{
+    simRtc.enableInterrupts(inHours[i], inMinutes[i], 0);
+}
+
+// The time block codec on its own, against the per-register version
+static void benchDecode(uint8_t i)
+{
+    DateTime dt;
+    sink += Ds3231Codec::decode(inBlocks[i], dt) + dt.date();
+}
+
+static void benchDecodeBytewise(uint8_t i)
+{
+    sink += Ds3231Codec::validBytewise(inBlocks[i]) + Ds3231Codec::decodeBytewise(inBlocks[i]).date();
+}
+
+static void benchEncode(uint8_t i)
+{
+    uint8_t buf[RTC_TIME_BLOCK_LEN];
+    Ds3231Codec::encode(inDates[i], buf);
+    sink += buf[0];
+}
+
+static void benchEncodeBytewise(uint8_t i)
+{
+    uint8_t buf[RTC_TIME_BLOCK_LEN];
+    Ds3231Codec::encodeBytewise(inDates[i], buf);
+    sink += buf[0];
+}
+
+static void benchAddToString(uint8_t i)
+{
+    String str;
+    inDates[i].addToString(str);
+    sink += str.length();
+}
+
+void setup()
+{
+    Serial.begin(57600);
+    simRtc.begin();
+    fillInputs();
+
+    Serial.print(F("F_CPU,"));
+    Serial.println(F_CPU);
+    Serial.println(F("benchmark,cycles_min,cycles_avg,cycles_max,us_avg,stack_bytes"));
+    Serial.flush();
+
+    startCycleCounter();
+    report("now", benchNow);
+    report("setEpoch", benchSetEpoch);
+    report("DateTime(long)", benchDateTimeLong);
+    report("RtcCodec::decode", benchDecode);
+    report("RtcCodec::decodeBytewise", benchDecodeBytewise);
+    report("RtcCodec::encode", benchEncode);
+    report("RtcCodec::encodeBytewise", benchEncodeBytewise);
+    report("enableInterrupts(periodicity)", benchEnableInterruptsPeriodic);
+    report("enableInterrupts(hh24,mm,ss)", benchEnableInterruptsDaily);
+    report("addToString", benchAddToString);
+    stopCycleCounter();
+
+    // Sleeping with interrupts off ends a simavr run
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop()
+{
+}
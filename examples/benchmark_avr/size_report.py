@@ -0,0 +1,28 @@
+# PlatformIO post script: after linking, list the flash taken by the
+# functions the benchmark measures. The whole-image flash and RAM are in
+# PlatformIO's own size summary.
+
+Import("env")
+
+import re
+import subprocess
+
+FUNCTIONS = re.compile(
+    r"::(now|setEpoch|enableInterrupts\w*|addToString|readRegisters|writeRegisters)\(|"
+    r"DateTime::DateTime\(\S*Step|DateTime::fromEpoch64|"
+    r"RtcCodec<\S*>::(decode|encode|valid)\w*\("
+)
+
+
+def size_report(source, target, env):
+    nm = env.subst("$CC").replace("gcc", "nm")
+    elf = str(target[0])
+    out = subprocess.check_output([nm, "-C", "-S", "--size-sort", elf], universal_newlines=True)
+    print("Flash bytes per function:")
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in "tTwW" and FUNCTIONS.search(parts[3]):
+            print("%6d  %s" % (int(parts[1], 16), parts[3]))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)
@@ -0,0 +1,41 @@
+// Local time with daylight saving, and a new "log file" at local midnight.
+//
+// The RTC runs on UTC, as PCsyncBinary.py sets it (see PCsync). tz_eastern.h was made with
+//   python extras/tzgen.py "EST5EDT,M3.2.0,M11.1.0" tzEastern --first 2007 --verify America/New_York
+// Run it with your own TZ string for another zone.
+
+#include <Wire.h>
+#include "Sodaq_DS3231.h"
+#include "Sodaq_LocalTime.h"
+#include "tz_eastern.h"
+
+using namespace sodaq_DS3231_nm;
+
+LocalTime local(tzEastern);
+
+void setup ()
+{
+    Serial.begin(57600);
+    Wire.begin();
+    rtcExtPhy.begin();
+}
+
+void loop ()
+{
+    uint32_t utc = rtcExtPhy.now().get();
+
+    // Only computes anything once a day
+    if (local.dayChanged(utc)) {
+        char name[13];
+        DateTime day = local.toLocal(DateTime((long)utc));
+        snprintf(name, sizeof(name), "%04d%02d%02d.CSV", day.year(), day.month(), day.date());
+        Serial.print("New log file ");
+        Serial.println(name);
+    }
+
+    DateTime now = local.toLocal(DateTime((long)utc));
+    now.printTo(Serial);
+    Serial.print(' ');
+    Serial.println(local.abbreviation(utc));
+    delay(1000);
+}
@@ -0,0 +1,110 @@
+// Generated by extras/tzgen.py, do not edit.
+// TZ "EST5EDT,M3.2.0,M11.1.0", 2007..2099
+
+#ifndef TZ_EASTERN_H
+#define TZ_EASTERN_H
+
+#include <Sodaq_LocalTime.h>
+
+// DST start and end per year, UTC seconds since 2000
+static const uint32_t tzEastern_changes[] SODAQ_TZ_PROGMEM = {
+     226911600UL,  247471200UL,     // 2007
+     258361200UL,  278920800UL,     // 2008
+     289810800UL,  310370400UL,     // 2009
+     321865200UL,  342424800UL,     // 2010
+     353314800UL,  373874400UL,     // 2011
+     384764400UL,  405324000UL,     // 2012
+     416214000UL,  436773600UL,     // 2013
+     447663600UL,  468223200UL,     // 2014
+     479113200UL,  499672800UL,     // 2015
+     511167600UL,  531727200UL,     // 2016
+     542617200UL,  563176800UL,     // 2017
+     574066800UL,  594626400UL,     // 2018
+     605516400UL,  626076000UL,     // 2019
+     636966000UL,  657525600UL,     // 2020
+     669020400UL,  689580000UL,     // 2021
+     700470000UL,  721029600UL,     // 2022
+     731919600UL,  752479200UL,     // 2023
+     763369200UL,  783928800UL,     // 2024
+     794818800UL,  815378400UL,     // 2025
+     826268400UL,  846828000UL,     // 2026
+     858322800UL,  878882400UL,     // 2027
+     889772400UL,  910332000UL,     // 2028
+     921222000UL,  941781600UL,     // 2029
+     952671600UL,  973231200UL,     // 2030
+     984121200UL, 1004680800UL,     // 2031
+    1016175600UL, 1036735200UL,     // 2032
+    1047625200UL, 1068184800UL,     // 2033
+    1079074800UL, 1099634400UL,     // 2034
+    1110524400UL, 1131084000UL,     // 2035
+    1141974000UL, 1162533600UL,     // 2036
+    1173423600UL, 1193983200UL,     // 2037
+    1205478000UL, 1226037600UL,     // 2038
+    1236927600UL, 1257487200UL,     // 2039
+    1268377200UL, 1288936800UL,     // 2040
+    1299826800UL, 1320386400UL,     // 2041
+    1331276400UL, 1351836000UL,     // 2042
+    1362726000UL, 1383285600UL,     // 2043
+    1394780400UL, 1415340000UL,     // 2044
+    1426230000UL, 1446789600UL,     // 2045
+    1457679600UL, 1478239200UL,     // 2046
+    1489129200UL, 1509688800UL,     // 2047
+    1520578800UL, 1541138400UL,     // 2048
+    1552633200UL, 1573192800UL,     // 2049
+    1584082800UL, 1604642400UL,     // 2050
+    1615532400UL, 1636092000UL,     // 2051
+    1646982000UL, 1667541600UL,     // 2052
+    1678431600UL, 1698991200UL,     // 2053
+    1709881200UL, 1730440800UL,     // 2054
+    1741935600UL, 1762495200UL,     // 2055
+    1773385200UL, 1793944800UL,     // 2056
+    1804834800UL, 1825394400UL,     // 2057
+    1836284400UL, 1856844000UL,     // 2058
+    1867734000UL, 1888293600UL,     // 2059
+    1899788400UL, 1920348000UL,     // 2060
+    1931238000UL, 1951797600UL,     // 2061
+    1962687600UL, 1983247200UL,     // 2062
+    1994137200UL, 2014696800UL,     // 2063
+    2025586800UL, 2046146400UL,     // 2064
+    2057036400UL, 2077596000UL,     // 2065
+    2089090800UL, 2109650400UL,     // 2066
+    2120540400UL, 2141100000UL,     // 2067
+    2151990000UL, 2172549600UL,     // 2068
+    2183439600UL, 2203999200UL,     // 2069
+    2214889200UL, 2235448800UL,     // 2070
+    2246338800UL, 2266898400UL,     // 2071
+    2278393200UL, 2298952800UL,     // 2072
+    2309842800UL, 2330402400UL,     // 2073
+    2341292400UL, 2361852000UL,     // 2074
+    2372742000UL, 2393301600UL,     // 2075
+    2404191600UL, 2424751200UL,     // 2076
+    2436246000UL, 2456805600UL,     // 2077
+    2467695600UL, 2488255200UL,     // 2078
+    2499145200UL, 2519704800UL,     // 2079
+    2530594800UL, 2551154400UL,     // 2080
+    2562044400UL, 2582604000UL,     // 2081
+    2593494000UL, 2614053600UL,     // 2082
+    2625548400UL, 2646108000UL,     // 2083
+    2656998000UL, 2677557600UL,     // 2084
+    2688447600UL, 2709007200UL,     // 2085
+    2719897200UL, 2740456800UL,     // 2086
+    2751346800UL, 2771906400UL,     // 2087
+    2783401200UL, 2803960800UL,     // 2088
+    2814850800UL, 2835410400UL,     // 2089
+    2846300400UL, 2866860000UL,     // 2090
+    2877750000UL, 2898309600UL,     // 2091
+    2909199600UL, 2929759200UL,     // 2092
+    2940649200UL, 2961208800UL,     // 2093
+    2972703600UL, 2993263200UL,     // 2094
+    3004153200UL, 3024712800UL,     // 2095
+    3035602800UL, 3056162400UL,     // 2096
+    3067052400UL, 3087612000UL,     // 2097
+    3098502000UL, 3119061600UL,     // 2098
+    3129951600UL, 3150511200UL,     // 2099
+};
+
+static const sodaq_DS3231_nm::TimeZone tzEastern = {
+    -300, -240, 2007, 93, tzEastern_changes, "EST", "EDT"
+};
+
+#endif
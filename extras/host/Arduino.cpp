@@ -0,0 +1,186 @@
+// Arduino core stand-in, see Arduino.h
+
+#include "Arduino.h"
+#include <stdio.h>
+
+HardwareSerial Serial;
+
+static uint64_t s_nowUs;
+static bool s_stepping;
+static HostTimed *s_timed;
+
+#define HOST_IRQ_COUNT  64
+static void (*s_isr[HOST_IRQ_COUNT])();
+
+HostTimed::HostTimed() : _next(s_timed)
+{
+    s_timed = this;
+}
+
+HostTimed::~HostTimed()
+{
+    for (HostTimed **p = &s_timed; *p; p = &(*p)->_next) {
+        if (*p == this) {
+            *p = _next;
+            break;
+        }
+    }
+}
+
+uint64_t hostMicros()
+{
+    return s_nowUs;
+}
+
+void hostAdvanceUs(uint64_t us)
+{
+    uint64_t target = s_nowUs + us;
+    if (s_stepping) {
+        // Time spent inside a step, e.g. by an interrupt handler
+        s_nowUs = target;
+        return;
+    }
+    s_stepping = true;
+    for (;;) {
+        HostTimed *first = 0;
+        uint64_t firstUs = target;
+        for (HostTimed *t = s_timed; t; t = t->_next) {
+            uint64_t at = t->nextUs();
+            if (at <= firstUs) {
+                first = t;
+                firstUs = at;
+            }
+        }
+        if (!first)
+            break;
+        if (firstUs > s_nowUs)
+            s_nowUs = firstUs;
+        first->step();
+    }
+    if (target > s_nowUs)
+        s_nowUs = target;
+    s_stepping = false;
+}
+
+unsigned long millis()
+{
+    unsigned long ms = s_nowUs / 1000;
+    hostAdvanceUs(1);
+    return ms;
+}
+
+unsigned long micros()
+{
+    unsigned long us = (unsigned long)s_nowUs;
+    hostAdvanceUs(1);
+    return us;
+}
+
+void delay(unsigned long ms)
+{
+    hostAdvanceUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hostAdvanceUs(us);
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+// Every line idles high, so a bus recovery finds SDA released
+int digitalRead(uint8_t)
+{
+    return HIGH;
+}
+
+void attachInterrupt(uint8_t irq, void (*isr)(), int)
+{
+    if (irq < HOST_IRQ_COUNT)
+        s_isr[irq] = isr;
+}
+
+void detachInterrupt(uint8_t irq)
+{
+    if (irq < HOST_IRQ_COUNT)
+        s_isr[irq] = 0;
+}
+
+void hostRaiseInterrupt(uint8_t irq)
+{
+    if (irq < HOST_IRQ_COUNT && s_isr[irq])
+        s_isr[irq]();
+}
+
+size_t Print::write(const uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while (len--)
+        n += write(*buf++);
+    return n;
+}
+
+size_t Print::print(long v, int base)
+{
+    if (base == DEC) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%ld", v);
+        return write(buf);
+    }
+    return print((unsigned long)v, base);
+}
+
+size_t Print::print(unsigned long v, int base)
+{
+    char buf[72];
+    char *p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2 || base > 36)
+        base = DEC;
+    do {
+        uint8_t digit = v % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        v /= base;
+    } while (v);
+    return write(p);
+}
+
+size_t Print::print(double v, int digits)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(buf);
+}
+
+size_t Stream::readBytes(uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len && available() > 0)
+        buf[n++] = read();
+    return n;
+}
+
+int HostStream::read()
+{
+    if (rx.empty())
+        return -1;
+    uint8_t c = rx.front();
+    rx.pop_front();
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+    return fwrite(buf, 1, len, stdout);
+}
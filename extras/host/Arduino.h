@@ -0,0 +1,169 @@
+// Arduino core stand-in for building the library on a Linux host.
+//
+// Time is simulated: millis() and micros() read a microsecond clock that
+// only moves when something spends time. delay() and delayMicroseconds()
+// advance it, every bus byte advances it (see Wire.h), and each call to
+// millis() or micros() costs 1 us so that busy-wait loops end. Devices
+// that change with time (SimDs3231) register a HostTimed and are stepped
+// through every instant they asked for, in order, as the clock passes it.
+//
+// Only what the library and its host tests use is provided.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <deque>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define FALLING         2
+#define DEC             10
+#define HEX             16
+#define SDA             20
+#define SCL             21
+
+#define PROGMEM
+#define PSTR(s)         (s)
+class __FlashStringHelper;
+#define F(s)            (reinterpret_cast<const __FlashStringHelper *>(s))
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#define pgm_read_byte_near(p)   (*(const uint8_t *)(p))
+#define pgm_read_word(p)        (*(const uint16_t *)(p))
+#define pgm_read_dword(p)       (*(const uint32_t *)(p))
+#define memcpy_P        memcpy
+#define strlen_P        strlen
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Interrupts are simulated by direct calls from the clock, never
+// concurrently, so there is nothing to mask
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(uint8_t irq, void (*isr)(), int mode);
+void detachInterrupt(uint8_t irq);
+
+// Something that changes with simulated time. step() is called with the
+// clock at nextUs(), for as long as that is at or before the new time.
+class HostTimed {
+public:
+    HostTimed();
+    virtual ~HostTimed();
+    virtual uint64_t nextUs() = 0;
+    virtual void step() = 0;
+
+private:
+    HostTimed *_next;
+    friend void hostAdvanceUs(uint64_t us);
+};
+
+uint64_t hostMicros();                  // The clock, without spending time
+void hostAdvanceUs(uint64_t us);        // Spend time, stepping every HostTimed
+// The interrupt handler attached to irq, called by simulated devices
+void hostRaiseInterrupt(uint8_t irq);
+
+class String {
+public:
+    String(const char *s = "") : _s(s) {}
+    String(const std::string &s) : _s(s) {}
+    explicit String(long v) : _s(std::to_string(v)) {}
+
+    String &operator+=(const String &s) { _s += s._s; return *this; }
+    String &operator+=(const char *s) { _s += s; return *this; }
+    String &operator+=(char c) { _s += c; return *this; }
+    String &operator+=(int v) { _s += std::to_string(v); return *this; }
+    String &operator+=(unsigned int v) { _s += std::to_string(v); return *this; }
+    String &operator+=(long v) { _s += std::to_string(v); return *this; }
+    String &operator+=(unsigned long v) { _s += std::to_string(v); return *this; }
+    bool concat(const char *s, unsigned int n) { _s.append(s, n); return true; }
+    bool reserve(unsigned int n) { _s.reserve(n); return true; }
+    unsigned int length() const { return _s.size(); }
+    const char *c_str() const { return _s.c_str(); }
+    bool operator==(const char *s) const { return _s == s; }
+
+private:
+    std::string _s;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len);
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(double v, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <class T> size_t println(T v, int arg) { size_t n = print(v, arg); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long) {}
+    size_t readBytes(uint8_t *buf, size_t len);
+};
+
+// A Stream the test feeds and reads back, e.g. the port of a protocol
+class HostStream : public Stream {
+public:
+    size_t write(uint8_t c) { tx.push_back(c); return 1; }
+    using Print::write;
+    int available() { return rx.size(); }
+    int read();
+    int peek() { return rx.empty() ? -1 : rx.front(); }
+    void feed(const uint8_t *buf, size_t len) { rx.insert(rx.end(), buf, buf + len); }
+
+    std::deque<uint8_t> rx;     // Bytes waiting for the sketch
+    std::deque<uint8_t> tx;     // Bytes the sketch wrote
+};
+
+// Writes to standard output
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void flush() {}
+    operator bool() const { return true; }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t len);
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,34 @@
+// Checks for the host tests. A failed check prints its line and the test
+// goes on; main() returns hostTestResult(), which ctest reads.
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                    #actual, a_, e_); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+static inline int hostTestResult()
+{
+    if (hostTestFailures)
+        fprintf(stderr, "%d checks failed\n", hostTestFailures);
+    return hostTestFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,337 @@
+// A DS3231 on the simulated I2C bus, see SimDs3231.h
+
+#include "SimDs3231.h"
+
+#define REG_SEC     0x00
+#define REG_HOUR    0x02
+#define REG_WDAY    0x03
+#define REG_DATE    0x04
+#define REG_MONTH   0x05
+#define REG_YEAR    0x06
+#define REG_AL1SEC  0x07
+#define REG_AL2MIN  0x0B
+#define REG_CONTROL 0x0E
+#define REG_STATUS  0x0F
+#define REG_AGING   0x10
+#define REG_TEMP    0x11
+
+#define CTL_CONV    0x20
+#define CTL_RS      0x18
+#define CTL_INTCN   0x04
+#define CTL_A2IE    0x02
+#define CTL_A1IE    0x01
+#define ST_OSF      0x80
+#define ST_EN32KHZ  0x08
+#define ST_BSY      0x04
+#define ST_A2F      0x02
+#define ST_A1F      0x01
+
+// Bits that exist in each register; the others read 0
+static const uint8_t regMask[SIM_DS3231_REG_COUNT] = {
+    0x7F, 0x7F, 0x7F, 0x07, 0x3F, 0x9F, 0xFF,   // Time
+    0xFF, 0xFF, 0xFF, 0xFF,                     // Alarm 1
+    0xFF, 0xFF, 0xFF,                           // Alarm 2
+    0xFF, 0x8F, 0xFF, 0xFF, 0xC0,               // Control, status, aging, temperature
+};
+
+static uint8_t bcd2bin(uint8_t v) { return v - 6 * (v >> 4); }
+static uint8_t bin2bcd(uint8_t v) { return v + 6 * (v / 10); }
+
+static uint8_t daysInMonth(uint8_t month, uint8_t year)
+{
+    static const uint8_t days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    // The DS3231 takes every year divisible by 4 as a leap year
+    return days[month - 1] + (month == 2 && year % 4 == 0);
+}
+
+SimDs3231::SimDs3231() : _irq(SIM_DS3231_NO_IRQ)
+{
+    _ambient = 100;     // 25.00 deg C
+    _ppm = 0;
+    powerOn();
+}
+
+void SimDs3231::powerOn()
+{
+    static const uint8_t initial[SIM_DS3231_REG_COUNT] = {
+        0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x1C, ST_OSF | ST_EN32KHZ, 0x00, 0x00, 0x00,
+    };
+    memcpy(_regs, initial, sizeof(_regs));
+    latch();
+    _ptr = 0;
+    _ptrSet = false;
+    _present = true;
+    _secondUs = hostMicros();
+    _convEndUs = 0;
+    _autoConvUs = hostMicros() + SIM_DS3231_AUTO_CONV_US;
+    _agingApplied = 0;
+    _intLow = false;
+    // The device converts at power on
+    finishConversion();
+}
+
+void SimDs3231::setReg(uint8_t r, uint8_t value)
+{
+    if (r >= SIM_DS3231_REG_COUNT)
+        return;
+    _regs[r] = value & regMask[r];
+    latch();
+    updateInt();
+}
+
+void SimDs3231::setTime(uint16_t year, uint8_t month, uint8_t date, uint8_t hour,
+                        uint8_t minute, uint8_t second, uint8_t wday)
+{
+    _regs[REG_SEC] = bin2bcd(second);
+    _regs[REG_SEC + 1] = bin2bcd(minute);
+    _regs[REG_HOUR] = bin2bcd(hour);
+    _regs[REG_WDAY] = wday;
+    _regs[REG_DATE] = bin2bcd(date);
+    _regs[REG_MONTH] = bin2bcd(month) | (year >= 2100 ? 0x80 : 0);
+    _regs[REG_YEAR] = bin2bcd(year % 100);
+    _secondUs = hostMicros();
+    latch();
+}
+
+uint32_t SimDs3231::y2k() const
+{
+    uint16_t year = bcd2bin(_regs[REG_YEAR]) + (_regs[REG_MONTH] & 0x80 ? 100 : 0);
+    uint8_t month = bcd2bin(_regs[REG_MONTH] & 0x1F);
+    uint32_t days = bcd2bin(_regs[REG_DATE]) - 1;
+    for (uint16_t y = 0; y < year; y++)
+        days += 365 + (y % 4 == 0 && y != 100);
+    for (uint8_t m = 1; m < month; m++)
+        days += daysInMonth(m, year == 100 ? 1 : year);
+    return ((days * 24 + bcd2bin(_regs[REG_HOUR] & 0x3F)) * 60
+            + bcd2bin(_regs[REG_SEC + 1])) * 60 + bcd2bin(_regs[REG_SEC]);
+}
+
+bool SimDs3231::intAsserted() const
+{
+    uint8_t ctl = _regs[REG_CONTROL];
+    uint8_t st = _regs[REG_STATUS];
+    return (ctl & CTL_INTCN)
+        && (((ctl & CTL_A1IE) && (st & ST_A1F)) || ((ctl & CTL_A2IE) && (st & ST_A2F)));
+}
+
+void SimDs3231::updateInt()
+{
+    bool low = intAsserted();
+    if (low && !_intLow && _irq != SIM_DS3231_NO_IRQ)
+        hostRaiseInterrupt(_irq);
+    _intLow = low;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// I2C
+
+bool SimDs3231::start(bool read)
+{
+    if (!_present)
+        return false;
+    latch();
+    if (!read)
+        _ptrSet = false;
+    return true;
+}
+
+bool SimDs3231::write(uint8_t value)
+{
+    if (!_ptrSet) {
+        _ptr = value;
+        _ptrSet = true;
+        return true;
+    }
+    writeReg(_ptr, value);
+    nextPtr();
+    return true;
+}
+
+uint8_t SimDs3231::read()
+{
+    uint8_t value = 0;
+    if (_ptr < sizeof(_latch))
+        value = _latch[_ptr];
+    else if (_ptr < SIM_DS3231_REG_COUNT)
+        value = _regs[_ptr];
+    nextPtr();
+    return value;
+}
+
+void SimDs3231::nextPtr()
+{
+    if (_ptr >= SIM_DS3231_REG_COUNT - 1) {
+        _ptr = 0;
+        latch();
+    } else {
+        _ptr++;
+    }
+}
+
+void SimDs3231::writeReg(uint8_t r, uint8_t value)
+{
+    if (r >= SIM_DS3231_REG_COUNT || r >= REG_TEMP)
+        return;     // Temperature is read only
+    value &= regMask[r];
+    if (r == REG_SEC) {
+        _secondUs = hostMicros();   // Restarts the countdown chain
+    } else if (r == REG_CONTROL) {
+        bool start = (value & CTL_CONV) && !(_regs[REG_STATUS] & ST_BSY);
+        // CONV only clears when the conversion is done
+        value = (value & ~CTL_CONV) | (_regs[REG_CONTROL] & CTL_CONV);
+        _regs[r] = value;
+        if (start)
+            startConversion(true);
+        updateInt();
+        return;
+    } else if (r == REG_STATUS) {
+        uint8_t old = _regs[r];
+        value = (old & value & (ST_OSF | ST_A2F | ST_A1F)) | (value & ST_EN32KHZ) | (old & ST_BSY);
+    }
+    _regs[r] = value;
+    updateInt();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Time
+
+uint64_t SimDs3231::nextUs()
+{
+    uint64_t next = nextSecondUs();
+    if (_autoConvUs < next)
+        next = _autoConvUs;
+    if (_convEndUs && _convEndUs < next)
+        next = _convEndUs;
+    return next;
+}
+
+void SimDs3231::step()
+{
+    uint64_t now = hostMicros();
+    if (_convEndUs && now >= _convEndUs)
+        finishConversion();
+    if (now >= _autoConvUs) {
+        _autoConvUs += SIM_DS3231_AUTO_CONV_US;
+        if (!_convEndUs)
+            startConversion(false);
+    }
+    if (now >= nextSecondUs())
+        tick();
+}
+
+void SimDs3231::tick()
+{
+    _secondUs += periodUs();
+
+    uint8_t sec = bcd2bin(_regs[REG_SEC]) + 1;
+    bool carry = sec == 60;
+    _regs[REG_SEC] = carry ? 0 : bin2bcd(sec);
+    if (carry) {
+        uint8_t min = bcd2bin(_regs[REG_SEC + 1]) + 1;
+        carry = min == 60;
+        _regs[REG_SEC + 1] = carry ? 0 : bin2bcd(min);
+    }
+    if (carry) {
+        uint8_t hr = _regs[REG_HOUR];
+        if (hr & 0x40) {
+            // 12 hour mode, bit 5 is PM: 11 AM -> 12 PM -> 1 PM, 11 PM -> 12 AM
+            uint8_t h = bcd2bin(hr & 0x1F) % 12 + 1;
+            bool pm = (hr & 0x20) != 0;
+            if (h == 12)
+                pm = !pm;
+            carry = h == 12 && !pm;
+            _regs[REG_HOUR] = 0x40 | (pm ? 0x20 : 0) | bin2bcd(h);
+        } else {
+            uint8_t h = bcd2bin(hr & 0x3F) + 1;
+            carry = h == 24;
+            _regs[REG_HOUR] = carry ? 0 : bin2bcd(h);
+        }
+    }
+    if (carry) {
+        _regs[REG_WDAY] = _regs[REG_WDAY] % 7 + 1;
+        uint8_t year = bcd2bin(_regs[REG_YEAR]);
+        uint8_t month = bcd2bin(_regs[REG_MONTH] & 0x1F);
+        uint8_t date = bcd2bin(_regs[REG_DATE]) + 1;
+        carry = date > daysInMonth(month, year);
+        _regs[REG_DATE] = carry ? 1 : bin2bcd(date);
+        if (carry) {
+            uint8_t century = _regs[REG_MONTH] & 0x80;
+            if (++month > 12) {
+                month = 1;
+                if (++year > 99) {
+                    year = 0;
+                    century ^= 0x80;
+                }
+                _regs[REG_YEAR] = bin2bcd(year);
+            }
+            _regs[REG_MONTH] = century | bin2bcd(month);
+        }
+    }
+
+    if (alarm1Matches())
+        _regs[REG_STATUS] |= ST_A1F;
+    if (alarm2Matches())
+        _regs[REG_STATUS] |= ST_A2F;
+    uint8_t ctl = _regs[REG_CONTROL];
+    if (!(ctl & CTL_INTCN) && !(ctl & CTL_RS) && _irq != SIM_DS3231_NO_IRQ)
+        hostRaiseInterrupt(_irq);   // 1 Hz SQW falling edge
+    updateInt();
+}
+
+// Fields with their mask bit (7) clear must match; day/date by DY/DT (bit 6)
+bool SimDs3231::alarm1Matches() const
+{
+    const uint8_t *a = &_regs[REG_AL1SEC];
+    if (!(a[0] & 0x80) && a[0] != _regs[REG_SEC])
+        return false;
+    if (!(a[1] & 0x80) && a[1] != _regs[REG_SEC + 1])
+        return false;
+    if (!(a[2] & 0x80) && a[2] != _regs[REG_HOUR])
+        return false;
+    if (a[3] & 0x80)
+        return true;
+    if (a[3] & 0x40)
+        return (a[3] & 0x0F) == _regs[REG_WDAY];
+    return (a[3] & 0x3F) == _regs[REG_DATE];
+}
+
+// Alarm 2 has no seconds register and matches at second 00
+bool SimDs3231::alarm2Matches() const
+{
+    const uint8_t *a = &_regs[REG_AL2MIN];
+    if (_regs[REG_SEC] != 0)
+        return false;
+    if (!(a[0] & 0x80) && a[0] != _regs[REG_SEC + 1])
+        return false;
+    if (!(a[1] & 0x80) && a[1] != _regs[REG_HOUR])
+        return false;
+    if (a[2] & 0x80)
+        return true;
+    if (a[2] & 0x40)
+        return (a[2] & 0x0F) == _regs[REG_WDAY];
+    return (a[2] & 0x3F) == _regs[REG_DATE];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Temperature
+
+void SimDs3231::startConversion(bool user)
+{
+    _convEndUs = hostMicros() + SIM_DS3231_TCONV_US;
+    _regs[REG_STATUS] |= ST_BSY;
+    if (user)
+        _regs[REG_CONTROL] |= CTL_CONV;
+}
+
+void SimDs3231::finishConversion()
+{
+    _convEndUs = 0;
+    _regs[REG_STATUS] &= ~ST_BSY;
+    _regs[REG_CONTROL] &= ~CTL_CONV;
+    // 10-bit two's complement: the integer part, then the quarters in bits 7:6
+    _regs[REG_TEMP] = (uint8_t)(_ambient >> 2);
+    _regs[REG_TEMP + 1] = (uint8_t)((_ambient & 3) << 6);
+    _agingApplied = (int8_t)_regs[REG_AGING];
+}
@@ -0,0 +1,102 @@
+// A DS3231 on the simulated I2C bus, register for register.
+//
+// Registers 0x00-0x12 as in the datasheet (and the DS3231_*_REG defines):
+//  - the time keeps counting with the simulated clock, in BCD, with the
+//    12/24 hour bit, leap years and the century bit; writing the seconds
+//    register restarts the second
+//  - reads of 0x00-0x06 come from a copy taken at each START and when the
+//    register pointer wraps to 0, so a burst read never tears
+//  - Alarm 1 and Alarm 2 match with their mask and DY/DT bits once per
+//    second and set A1F/A2F, which only clear when written 0; /INT goes
+//    low while INTCN and a flag with its enable bit are set
+//  - with INTCN clear and RS2:RS1 at 1 Hz, the SQW falling edge comes with
+//    each seconds update
+//  - setting CONV starts a temperature conversion: CONV and BSY stay set
+//    for SIM_DS3231_TCONV_US, then the temperature registers hold the
+//    ambient temperature. The device also converts every 64 s on its own
+//    (BSY only). A new aging offset takes effect at the next conversion.
+//  - OSF and EN32kHz are set at power on, OSF only clears when written 0
+//
+// attach() puts it on Wire at 0x68. Edges of /INT and SQW call the handler
+// attached with attachInterrupt() to setIrq()'s number.
+
+#ifndef SIMDS3231_H
+#define SIMDS3231_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define SIM_DS3231_ADDRESS      0x68
+#define SIM_DS3231_REG_COUNT    0x13
+#define SIM_DS3231_TCONV_US     125000UL
+#define SIM_DS3231_AUTO_CONV_US 64000000UL
+#define SIM_DS3231_NO_IRQ       0xFF
+
+class SimDs3231 : public HostI2cDevice, public HostTimed {
+public:
+    SimDs3231();
+
+    // Back to the power-on state: 2000-01-01 00:00:00, day 1, with control
+    // 0x1C and status 0x88
+    void powerOn();
+    void attach(TwoWire &wire = Wire) { wire.attach(SIM_DS3231_ADDRESS, *this); }
+    // A missing device NACKs its address
+    void setPresent(bool present) { _present = present; }
+
+    // Direct register access, without the side effects of a bus write
+    uint8_t reg(uint8_t r) const { return r < SIM_DS3231_REG_COUNT ? _regs[r] : 0; }
+    void setReg(uint8_t r, uint8_t value);
+    // Set the time registers (24 hour, year 2000-2199); the second starts now
+    void setTime(uint16_t year, uint8_t month, uint8_t date, uint8_t hour,
+                 uint8_t minute, uint8_t second, uint8_t wday);
+    // The time registers as seconds since 2000 (24 hour mode only)
+    uint32_t y2k() const;
+
+    void setAmbient(int16_t quarterDegC) { _ambient = quarterDegC; }
+    // Crystal error; the aging offset pulls it by -0.1 ppm per LSB
+    void setPpm(float ppm) { _ppm = ppm; }
+    float effectivePpm() const { return _ppm - 0.1f * _agingApplied; }
+    void setIrq(uint8_t irq) { _irq = irq; }
+
+    bool intAsserted() const;
+    bool converting() const { return _convEndUs != 0; }
+    // Simulated time at which the next second starts
+    uint64_t nextSecondUs() const { return (uint64_t)(_secondUs + periodUs() + 0.5); }
+
+    // HostI2cDevice
+    bool start(bool read);
+    bool write(uint8_t value);
+    uint8_t read();
+
+    // HostTimed
+    uint64_t nextUs();
+    void step();
+
+private:
+    double periodUs() const { return 1e6 / (1 + effectivePpm() * 1e-6); }
+    void writeReg(uint8_t r, uint8_t value);
+    void nextPtr();
+    void latch() { memcpy(_latch, _regs, sizeof(_latch)); }
+    void tick();
+    bool alarm1Matches() const;
+    bool alarm2Matches() const;
+    void startConversion(bool user);
+    void finishConversion();
+    void updateInt();
+
+    uint8_t _regs[SIM_DS3231_REG_COUNT];
+    uint8_t _latch[7];
+    uint8_t _ptr;
+    bool _ptrSet;
+    bool _present;
+    double _secondUs;       // Start of the current second
+    uint64_t _convEndUs;    // 0 when not converting
+    uint64_t _autoConvUs;
+    int16_t _ambient;
+    float _ppm;
+    int8_t _agingApplied;
+    uint8_t _irq;
+    bool _intLow;
+};
+
+#endif
@@ -0,0 +1,194 @@
+// TwoWire stand-in, see Wire.h
+
+#include "Wire.h"
+
+TwoWire Wire;
+
+// The TwoWire timeout the driver asks for, SODAQ_I2C_TIMEOUT_US
+#define HOST_WIRE_TIMEOUT_US    25000
+
+TwoWire::TwoWire()
+    : _hz(100000), _txAddress(0), _txLen(0), _txOverflow(false),
+      _rxLen(0), _rxPos(0), _fault(HOST_I2C_NACK_ADDRESS), _faultCount(0), _trace(0)
+{
+    memset(_devices, 0, sizeof(_devices));
+    resetCounters();
+}
+
+void TwoWire::attach(uint8_t address, HostI2cDevice &dev)
+{
+    detach(address);
+    for (uint8_t i = 0; i < HOST_WIRE_DEVICES; i++) {
+        if (!_devices[i].device) {
+            _devices[i].address = address;
+            _devices[i].device = &dev;
+            return;
+        }
+    }
+}
+
+void TwoWire::detach(uint8_t address)
+{
+    for (uint8_t i = 0; i < HOST_WIRE_DEVICES; i++) {
+        if (_devices[i].device && _devices[i].address == address)
+            _devices[i].device = 0;
+    }
+}
+
+HostI2cDevice *TwoWire::device(uint8_t address)
+{
+    for (uint8_t i = 0; i < HOST_WIRE_DEVICES; i++) {
+        if (_devices[i].device && _devices[i].address == address)
+            return _devices[i].device;
+    }
+    return 0;
+}
+
+void TwoWire::failNext(HostI2cFault fault, uint8_t count)
+{
+    _fault = fault;
+    _faultCount = count;
+}
+
+bool TwoWire::takeFault(HostI2cFault &fault)
+{
+    if (!_faultCount)
+        return false;
+    _faultCount--;
+    fault = _fault;
+    return true;
+}
+
+void TwoWire::spendBytes(uint32_t bytes)
+{
+    hostAdvanceUs((uint64_t)bytes * 9 * 1000000UL / _hz);
+}
+
+void TwoWire::startCondition(uint8_t address, bool read)
+{
+    _counters.starts++;
+    if (_trace)
+        fprintf(_trace, "S %02X %c", address, read ? 'R' : 'W');
+}
+
+void TwoWire::stopCondition(HostI2cDevice *dev)
+{
+    _counters.stops++;
+    if (dev)
+        dev->stop();
+    if (_trace)
+        fprintf(_trace, " P\n");
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _txAddress = address;
+    _txLen = 0;
+    _txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+    if (_txLen >= HOST_WIRE_BUFFER_LEN) {
+        _txOverflow = true;
+        return 0;
+    }
+    _tx[_txLen++] = value;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len && write(buf[n]))
+        n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    _counters.transmissions++;
+    if (_txOverflow)
+        return 1;
+
+    HostI2cFault fault = HOST_I2C_NACK_ADDRESS;
+    bool faulted = takeFault(fault);
+    if (faulted && fault == HOST_I2C_TIMEOUT) {
+        hostAdvanceUs(HOST_WIRE_TIMEOUT_US);
+        if (_trace)
+            fprintf(_trace, "S %02X W timeout\n", _txAddress);
+        return 5;
+    }
+
+    HostI2cDevice *dev = device(_txAddress);
+    startCondition(_txAddress, false);
+    spendBytes(1);
+    if (!dev || (faulted && fault == HOST_I2C_NACK_ADDRESS) || !dev->start(false)) {
+        _counters.addressNacks++;
+        if (_trace)
+            fprintf(_trace, " nack");
+        stopCondition(0);
+        return 2;
+    }
+    uint8_t result = 0;
+    for (uint8_t i = 0; i < _txLen; i++) {
+        spendBytes(1);
+        _counters.bytesWritten++;
+        if (_trace)
+            fprintf(_trace, " %02X", _tx[i]);
+        bool ack = !(faulted && fault == HOST_I2C_NACK_DATA && i > 0) && dev->write(_tx[i]);
+        if (!ack) {
+            _counters.dataNacks++;
+            if (_trace)
+                fprintf(_trace, " nack");
+            result = 3;
+            break;
+        }
+    }
+    if (sendStop || result)
+        stopCondition(dev);
+    else if (_trace)
+        fprintf(_trace, " |");
+    return result;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t len, bool sendStop)
+{
+    _counters.requests++;
+    _rxLen = 0;
+    _rxPos = 0;
+    if (len > HOST_WIRE_BUFFER_LEN)
+        len = HOST_WIRE_BUFFER_LEN;
+
+    HostI2cFault fault = HOST_I2C_NACK_ADDRESS;
+    bool faulted = takeFault(fault);
+    if (faulted && fault == HOST_I2C_TIMEOUT) {
+        hostAdvanceUs(HOST_WIRE_TIMEOUT_US);
+        if (_trace)
+            fprintf(_trace, "S %02X R timeout\n", address);
+        return 0;
+    }
+
+    HostI2cDevice *dev = device(address);
+    startCondition(address, true);
+    spendBytes(1);
+    if (!dev || (faulted && fault == HOST_I2C_NACK_ADDRESS) || !dev->start(true)) {
+        _counters.addressNacks++;
+        if (_trace)
+            fprintf(_trace, " nack");
+        stopCondition(0);
+        return 0;
+    }
+    if (faulted && fault == HOST_I2C_SHORT_READ && len > 0)
+        len--;
+    for (uint8_t i = 0; i < len; i++) {
+        spendBytes(1);
+        _rx[_rxLen++] = dev->read();
+        _counters.bytesRead++;
+        if (_trace)
+            fprintf(_trace, " %02X", _rx[i]);
+    }
+    if (sendStop)
+        stopCondition(dev);
+    return _rxLen;
+}
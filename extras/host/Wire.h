@@ -0,0 +1,108 @@
+// TwoWire stand-in for host builds: an I2C master in front of simulated
+// devices, counting every condition and byte it puts on the bus.
+//
+// As the AVR TwoWire, write() only fills a 32 byte buffer; the transfer
+// (START, address, bytes, STOP) happens in endTransmission(). requestFrom()
+// is a transfer of its own. Each byte on the bus, the address included,
+// costs 9 clock periods of simulated time (90 us at the default 100 kHz).
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+#include <stdio.h>
+
+#define HOST_WIRE_BUFFER_LEN    32
+#define HOST_WIRE_DEVICES       4
+
+// A slave on the simulated bus
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() {}
+    // START or repeated START addressed to the device; false NACKs it
+    virtual bool start(bool read) = 0;
+    virtual bool write(uint8_t value) = 0;  // false NACKs the byte
+    virtual uint8_t read() = 0;
+    virtual void stop() {}
+};
+
+// Bus traffic since the last resetCounters()
+struct HostI2cCounters {
+    uint32_t starts;        // START and repeated START conditions
+    uint32_t stops;         // STOP conditions
+    uint32_t transmissions; // endTransmission() calls
+    uint32_t requests;      // requestFrom() calls
+    uint32_t bytesWritten;  // Bytes after the address byte, e.g. the register pointer
+    uint32_t bytesRead;
+    uint32_t addressNacks;
+    uint32_t dataNacks;
+};
+
+// Faults for failNext(), each ending one transfer as TwoWire reports it
+enum HostI2cFault {
+    HOST_I2C_NACK_ADDRESS,  // endTransmission() 2, requestFrom() 0
+    HOST_I2C_NACK_DATA,     // endTransmission() 3 on the byte after the register pointer
+    HOST_I2C_SHORT_READ,    // requestFrom() returns 1 byte less than asked
+    HOST_I2C_TIMEOUT,       // endTransmission() 5, requestFrom() 0, after 25 ms
+};
+
+class TwoWire : public Stream {
+public:
+    TwoWire();
+
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t hz) { _hz = hz ? hz : 100000; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    size_t write(uint8_t value);
+    size_t write(const uint8_t *buf, size_t len);
+    using Print::write;
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t len, bool sendStop = true);
+    uint8_t requestFrom(int address, int len) { return requestFrom((uint8_t)address, (uint8_t)len); }
+
+    int available() { return _rxLen - _rxPos; }
+    int read() { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+    int peek() { return _rxPos < _rxLen ? _rx[_rxPos] : -1; }
+
+    // Host side
+    void attach(uint8_t address, HostI2cDevice &device);
+    void detach(uint8_t address);
+    const HostI2cCounters &counters() const { return _counters; }
+    void resetCounters() { memset(&_counters, 0, sizeof(_counters)); }
+    // Fail the next count transfers with fault
+    void failNext(HostI2cFault fault, uint8_t count = 1);
+    // Print every transfer, e.g. "S 68 W 0E 1C P", to out (0 stops)
+    void trace(FILE *out) { _trace = out; }
+
+private:
+    HostI2cDevice *device(uint8_t address);
+    bool takeFault(HostI2cFault &fault);
+    void spendBytes(uint32_t bytes);
+    void startCondition(uint8_t address, bool read);
+    void stopCondition(HostI2cDevice *dev);
+
+    struct Slot {
+        uint8_t address;
+        HostI2cDevice *device;
+    };
+    Slot _devices[HOST_WIRE_DEVICES];
+    uint32_t _hz;
+    uint8_t _txAddress;
+    uint8_t _tx[HOST_WIRE_BUFFER_LEN];
+    uint8_t _txLen;
+    bool _txOverflow;
+    uint8_t _rx[HOST_WIRE_BUFFER_LEN];
+    uint8_t _rxLen;
+    uint8_t _rxPos;
+    HostI2cCounters _counters;
+    HostI2cFault _fault;
+    uint8_t _faultCount;
+    FILE *_trace;
+};
+
+extern TwoWire Wire;
+
+#endif
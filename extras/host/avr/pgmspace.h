@@ -0,0 +1,8 @@
+// Program memory is ordinary memory on the host, see Arduino.h
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include "../Arduino.h"
+
+#endif
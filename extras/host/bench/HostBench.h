@@ -0,0 +1,72 @@
+// Wall clock timing for the host benchmarks, in the CSV layout of
+// examples/benchmark:
+//
+//   benchmark,inputs,iterations,ns_per_op,ops_per_sec
+//
+// A benchmark program run with --check only compares the new code with
+// the old one and exits non-zero on a difference, which is what ctest runs.
+
+#ifndef HOSTBENCH_H
+#define HOSTBENCH_H
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Keeps results alive so the timed loops aren't optimised out
+static volatile uint32_t benchSink;
+
+static bool benchCheckOnly(int argc, char **argv)
+{
+    return argc > 1 && strcmp(argv[1], "--check") == 0;
+}
+
+static void benchHeader()
+{
+    printf("benchmark,inputs,iterations,ns_per_op,ops_per_sec\n");
+}
+
+// Best time per input of 5 runs of body(), which does iterations passes
+// over inputs
+template <typename Body>
+static void benchRuns(const char *name, uint32_t inputs, uint32_t iterations, Body body)
+{
+    double best = 0;
+    for (uint8_t run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - t0;
+        double perOp = ns.count() / ((double)inputs * iterations);
+        if (run == 0 || perOp < best)
+            best = perOp;
+    }
+    printf("%s,%lu,%lu,%.2f,%.0f\n", name, (unsigned long)inputs, (unsigned long)iterations,
+           best, 1e9 / best);
+}
+
+// Run op(i) for each of inputs indices, iterations times, and print the
+// time per call. The best of 5 runs is taken.
+template <typename Op>
+static void bench(const char *name, uint32_t inputs, uint32_t iterations, Op op)
+{
+    benchRuns(name, inputs, iterations, [&]() {
+        for (uint32_t n = 0; n < iterations; n++) {
+            for (uint32_t i = 0; i < inputs; i++)
+                op(i);
+        }
+    });
+}
+
+// Run op() over all inputs at once, iterations times, and print the time
+// per input, for code that takes arrays
+template <typename Op>
+static void benchArray(const char *name, uint32_t inputs, uint32_t iterations, Op op)
+{
+    benchRuns(name, inputs, iterations, [&]() {
+        for (uint32_t n = 0; n < iterations; n++)
+            op();
+    });
+}
+
+#endif
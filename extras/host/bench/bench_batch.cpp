@@ -0,0 +1,93 @@
+// DateTimeBatch against the DateTime(long) loop it replaces, serial and
+// split across threads.
+
+#include <Sodaq_DateTimeBatch.h>
+#include "HostBench.h"
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+struct Columns {
+    explicit Columns(size_t n)
+        : year(n), month(n), date(n), hour(n), minute(n), second(n), wday(n) {}
+    DateTimeColumns cols()
+    {
+        DateTimeColumns c = { year.data(), month.data(), date.data(), hour.data(),
+                              minute.data(), second.data(), wday.data() };
+        return c;
+    }
+    std::vector<uint16_t> year;
+    std::vector<uint8_t> month, date, hour, minute, second, wday;
+};
+
+// The loop DateTimeBatch replaces
+static void legacyConvert(const std::vector<uint32_t> &y2k, Columns &out)
+{
+    for (size_t i = 0; i < y2k.size(); i++) {
+        DateTime dt(y2k[i]);
+        out.year[i] = dt.year();
+        out.month[i] = dt.month();
+        out.date[i] = dt.date();
+        out.hour[i] = dt.hour();
+        out.minute[i] = dt.minute();
+        out.second[i] = dt.second();
+        out.wday[i] = dt.dayOfWeek();
+    }
+}
+
+static bool sameColumns(const Columns &a, const Columns &b)
+{
+    return a.year == b.year && a.month == b.month && a.date == b.date && a.hour == b.hour
+           && a.minute == b.minute && a.second == b.second && a.wday == b.wday;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t last = DateTime(2099, 12, 31, 23, 59, 59, 5).get();
+    const size_t n = 1 << 20;
+    uint32_t state = 2463534242UL;
+    std::vector<uint32_t> y2k(n);
+    for (size_t i = 0; i < n; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        y2k[i] = i == 0 ? 0 : i == 1 ? last : state % (last + 1);
+    }
+
+    // Every element converts as DateTime(long)
+    Columns legacy(n), batch(n), parallel(n);
+    legacyConvert(y2k, legacy);
+    DateTimeBatch::fromY2k(y2k.data(), n, batch.cols());
+    DateTimeBatch::fromY2kParallel(y2k.data(), n, parallel.cols());
+    if (!sameColumns(legacy, batch) || !sameColumns(legacy, parallel)) {
+        printf("mismatch\n");
+        return 1;
+    }
+    if (benchCheckOnly(argc, argv))
+        return 0;
+
+    benchHeader();
+    benchArray("DateTime(long) loop", n, 20, [&]() {
+        legacyConvert(y2k, legacy);
+        benchSink += legacy.wday[n - 1];
+    });
+    benchArray("fromY2k()", n, 20, [&]() {
+        DateTimeBatch::fromY2k(y2k.data(), n, batch.cols());
+        benchSink += batch.wday[n - 1];
+    });
+    benchArray("fromY2kParallel()", n, 20, [&]() {
+        DateTimeBatch::fromY2kParallel(y2k.data(), n, parallel.cols());
+        benchSink += parallel.wday[n - 1];
+    });
+
+    const size_t stride = DT_FMT_MAX_LEN + 1;
+    std::vector<char> text(n * stride);
+    benchArray("formatY2k()", n, 2, [&]() {
+        benchSink += DateTimeBatch::formatY2k(y2k.data(), n, DT_FMT_ISO8601, text.data(), stride);
+    });
+    benchArray("formatY2kParallel()", n, 2, [&]() {
+        benchSink += DateTimeBatch::formatY2kParallel(y2k.data(), n, DT_FMT_ISO8601,
+                                                      text.data(), stride);
+    });
+    return 0;
+}
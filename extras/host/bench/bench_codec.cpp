@@ -0,0 +1,213 @@
+// The small conversions every time read and write goes through, as in
+// examples/benchmark: bcd2bin()/bin2bcd(), conv2d(), DayOfWeek(),
+// get()/date2days() and addToString(), on random inputs and on the
+// 2099-12-31 23:59:59 worst case. The date conversions are timed against
+// the v1.3.5 loops they replaced; the BCD ones are unchanged since then,
+// so they are timed alone.
+
+#include <Sodaq_DS3231.h>
+#include <Sodaq_RtcBackend.h>
+#include "HostBench.h"
+#include <string>
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+static const uint8_t legacyDaysInMonth[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+
+// The v1.3.5 date2days(), a loop over the months, valid for 2001..2099
+static uint16_t legacyDate2days(uint16_t y, uint8_t m, uint8_t d)
+{
+    if (y >= 2000)
+        y -= 2000;
+    uint16_t days = d;
+    for (uint8_t i = 1; i < m; ++i)
+        days += legacyDaysInMonth[i - 1];
+    if (m > 2 && y % 4 == 0)
+        ++days;
+    return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+// The v1.3.5 DayOfWeek(), Tomohiko Sakamoto's with an int table
+static uint8_t legacyDayOfWeek(int y, uint8_t m, uint8_t d)
+{
+    static int t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+    y -= m < 3;
+    return (y + y / 4 - y / 100 + y / 400 + t[m - 1] + d) % 7 + 1;
+}
+
+// The v1.3.5 get()
+static uint32_t legacyGet(const DateTime &dt)
+{
+    uint16_t days = legacyDate2days(dt.year(), dt.month(), dt.date());
+    return ((days * 24L + dt.hour()) * 60 + dt.minute()) * 60 + dt.second();
+}
+
+// The v1.3.5 conv2d()
+static uint8_t legacyConv2d(const char *p)
+{
+    uint8_t v = 0;
+    if ('0' <= *p && *p <= '9')
+        v = *p - '0';
+    return 10 * v + *++p - '0';
+}
+
+// The v1.3.5 addToString(), one String append per digit and separator
+static void add0Nd(String &str, uint16_t val, size_t width)
+{
+    if (width >= 5 && val < 1000)
+        str += '0';
+    if (width >= 4 && val < 100)
+        str += '0';
+    if (width >= 3 && val < 100)
+        str += '0';
+    if (width >= 2 && val < 10)
+        str += '0';
+    str += val;
+}
+
+static void legacyAddToString(String &str, const DateTime &dt)
+{
+    add0Nd(str, dt.year(), 4);
+    str += '-';
+    add0Nd(str, dt.month(), 2);
+    str += '-';
+    add0Nd(str, dt.date(), 2);
+    str += ' ';
+    add0Nd(str, dt.hour(), 2);
+    str += ':';
+    add0Nd(str, dt.minute(), 2);
+    str += ':';
+    add0Nd(str, dt.second(), 2);
+}
+
+// Every day of 2000-2099, every BCD byte and digit pair
+static bool check(uint32_t last)
+{
+    uint32_t mismatches = 0;
+    for (uint32_t t = 0; t <= last; t += 86400UL) {
+        // Walk the time of day through the hours, minutes and seconds
+        const DateTime dt(t + (t / 86400UL * 7919UL) % 86400UL);
+        String legacy, now;
+        legacyAddToString(legacy, dt);
+        dt.addToString(now);
+        if (DateTime::date2days(dt.year(), dt.month(), dt.date())
+                != legacyDate2days(dt.year(), dt.month(), dt.date())
+            || DateTime::DayOfWeek(dt.year(), dt.month(), dt.date())
+                != legacyDayOfWeek(dt.year(), dt.month(), dt.date())
+            || dt.get() != legacyGet(dt) || !(now == legacy.c_str())) {
+            if (mismatches++ < 10)
+                printf("mismatch at %lu: %s %s\n", (unsigned long)dt.get(), legacy.c_str(), now.c_str());
+        }
+    }
+    for (uint8_t v = 0; v < 100; v++) {
+        char digits[3] = { (char)('0' + v / 10), (char)('0' + v % 10), 0 };
+        char spaced[3] = { v < 10 ? ' ' : digits[0], digits[1], 0 };
+        if (bcd2bin(bin2bcd(v)) != v || bin2bcd(v) != ((v / 10) << 4 | v % 10)
+            || DateTime::conv2d(digits) != legacyConv2d(digits)
+            || DateTime::conv2d(spaced) != legacyConv2d(spaced)) {
+            if (mismatches++ < 10)
+                printf("mismatch at %u\n", v);
+        }
+    }
+    return mismatches == 0;
+}
+
+struct Inputs {
+    std::vector<DateTime> dates;
+    std::vector<uint8_t> bytes, bcd;
+    std::vector<char> digits;       // Two per input
+};
+
+// Random inputs, or all at the worst case: the last day of the last month
+// of 2099 takes the most month steps and the largest day count, and 99 the
+// most BCD tens
+static Inputs makeInputs(bool worst, uint32_t last)
+{
+    // xorshift32
+    static uint32_t state = 2463534242UL;
+    Inputs in;
+    for (uint32_t i = 0; i < 1024; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        uint8_t byte = worst ? 99 : state % 100;
+        in.dates.push_back(DateTime(worst ? last : state % (last + 1)));
+        in.bytes.push_back(byte);
+        in.bcd.push_back(bin2bcd(byte));
+        in.digits.push_back('0' + byte / 10);
+        in.digits.push_back('0' + byte % 10);
+    }
+    return in;
+}
+
+static void run(const Inputs &in, const char *kind)
+{
+    const uint32_t n = in.dates.size();
+    auto name = [&](const char *op) { return std::string(op) + " " + kind; };
+
+    bench(name("bcd2bin()").c_str(), n, 5000, [&](uint32_t i) {
+        benchSink += bcd2bin(in.bcd[i]);
+    });
+    bench(name("bin2bcd()").c_str(), n, 5000, [&](uint32_t i) {
+        benchSink += bin2bcd(in.bytes[i]);
+    });
+    bench(name("conv2d()").c_str(), n, 5000, [&](uint32_t i) {
+        benchSink += DateTime::conv2d(&in.digits[2 * i]);
+    });
+    bench(name("legacy conv2d()").c_str(), n, 5000, [&](uint32_t i) {
+        benchSink += legacyConv2d(&in.digits[2 * i]);
+    });
+    bench(name("DayOfWeek()").c_str(), n, 2000, [&](uint32_t i) {
+        const DateTime &dt = in.dates[i];
+        benchSink += DateTime::DayOfWeek(dt.year(), dt.month(), dt.date());
+    });
+    bench(name("legacy DayOfWeek()").c_str(), n, 2000, [&](uint32_t i) {
+        const DateTime &dt = in.dates[i];
+        benchSink += legacyDayOfWeek(dt.year(), dt.month(), dt.date());
+    });
+    bench(name("date2days()").c_str(), n, 2000, [&](uint32_t i) {
+        const DateTime &dt = in.dates[i];
+        benchSink += DateTime::date2days(dt.year(), dt.month(), dt.date());
+    });
+    bench(name("legacy date2days()").c_str(), n, 2000, [&](uint32_t i) {
+        const DateTime &dt = in.dates[i];
+        benchSink += legacyDate2days(dt.year(), dt.month(), dt.date());
+    });
+    // A DateTime made from its fields, which get() converts on every call
+    bench(name("get()").c_str(), n, 2000, [&](uint32_t i) {
+        const DateTime &src = in.dates[i];
+        const DateTime dt(src.year(), src.month(), src.date(), src.hour(), src.minute(),
+                          src.second(), src.dayOfWeek());
+        benchSink += dt.get();
+    });
+    bench(name("legacy get()").c_str(), n, 2000, [&](uint32_t i) {
+        benchSink += legacyGet(in.dates[i]);
+    });
+    bench(name("addToString()").c_str(), n, 500, [&](uint32_t i) {
+        String str;
+        str.reserve(DT_FMT_MAX_LEN);
+        in.dates[i].addToString(str);
+        benchSink += str.length();
+    });
+    bench(name("legacy addToString()").c_str(), n, 500, [&](uint32_t i) {
+        String str;
+        str.reserve(DT_FMT_MAX_LEN);
+        legacyAddToString(str, in.dates[i]);
+        benchSink += str.length();
+    });
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t last = DateTime(2099, 12, 31, 23, 59, 59, 5).get();
+    if (!check(last))
+        return 1;
+    if (benchCheckOnly(argc, argv))
+        return 0;
+
+    benchHeader();
+    run(makeInputs(false, last), "random");
+    run(makeInputs(true, last), "2099-12-31");
+    return 0;
+}
@@ -0,0 +1,116 @@
+// DateTime(long): the closed-form days-to-civil conversion against the
+// year and month loops it replaced, over 2000-2099.
+
+#include <Sodaq_DS3231.h>
+#include "HostBench.h"
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+static const uint32_t secondsPerDay = 86400UL;
+static const uint8_t legacyDaysInMonth[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+
+// Tomohiko Sakamoto's day of the week, 1 = Sunday, as the library's
+static uint8_t legacyDayOfWeek(int y, uint8_t m, uint8_t d)
+{
+    static const uint8_t t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+    y -= m < 3;
+    return (y + y / 4 - y / 100 + y / 400 + t[m - 1] + d) % 7 + 1;
+}
+
+// The v1.3.5 DateTime(long), with the day counter widened from int16_t so
+// it still converts after mid-2089
+struct LegacyDate {
+    uint8_t yOff, m, d, hh, mm, ss, wday;
+};
+
+static LegacyDate legacyFromY2k(long t)
+{
+    LegacyDate r;
+    r.ss = t % 60;
+    t /= 60;
+    r.mm = t % 60;
+    t /= 60;
+    r.hh = t % 24;
+    int32_t days = t / 24;
+    uint8_t leap;
+    for (r.yOff = 0; ; ++r.yOff) {
+        leap = r.yOff % 4 == 0;
+        if (days < 365 + leap)
+            break;
+        days -= 365 + leap;
+    }
+    for (r.m = 1; ; ++r.m) {
+        uint8_t daysPerMonth = legacyDaysInMonth[r.m - 1];
+        if (leap && r.m == 2)
+            ++daysPerMonth;
+        if (days < daysPerMonth)
+            break;
+        days -= daysPerMonth;
+    }
+    r.d = days + 1;
+    r.wday = legacyDayOfWeek(r.yOff + 2000, r.m, r.d);
+    return r;
+}
+
+static bool same(const DateTime &dt, const LegacyDate &l)
+{
+    return dt.year() == l.yOff + 2000 && dt.month() == l.m && dt.date() == l.d &&
+           dt.hour() == l.hh && dt.minute() == l.mm && dt.second() == l.ss &&
+           dt.dayOfWeek() == l.wday;
+}
+
+// Every day of 2000-2099 at a time of day that walks through the seconds
+static bool check(uint32_t last)
+{
+    uint32_t mismatches = 0;
+    for (uint32_t day = 0; day * secondsPerDay <= last; day++) {
+        uint32_t t = day * secondsPerDay + (day * 7919UL) % secondsPerDay;
+        if (t > last)
+            t = last;
+        DateTime dt(t);
+        if (!same(dt, legacyFromY2k(t)) || dt.get() != t) {
+            if (mismatches++ < 10)
+                printf("mismatch at %lu\n", (unsigned long)t);
+        }
+    }
+    return mismatches == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t last = DateTime(2099, 12, 31, 23, 59, 59, 5).get();
+    if (!check(last))
+        return 1;
+    if (benchCheckOnly(argc, argv))
+        return 0;
+
+    // xorshift32
+    uint32_t state = 2463534242UL;
+    std::vector<uint32_t> random(1024), worst(1024, last);
+    for (size_t i = 0; i < random.size(); i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        random[i] = state % (last + 1);
+    }
+
+    benchHeader();
+    bench("DateTime(long) random", random.size(), 2000, [&](uint32_t i) {
+        DateTime dt(random[i]);
+        benchSink += dt.date() + dt.month() + dt.year();
+    });
+    bench("legacy DateTime(long) random", random.size(), 2000, [&](uint32_t i) {
+        LegacyDate l = legacyFromY2k(random[i]);
+        benchSink += l.d + l.m + l.yOff;
+    });
+    bench("DateTime(long) 2099-12-31", worst.size(), 2000, [&](uint32_t i) {
+        DateTime dt(worst[i] - (i & 1));
+        benchSink += dt.date() + dt.month() + dt.year();
+    });
+    bench("legacy DateTime(long) 2099-12-31", worst.size(), 2000, [&](uint32_t i) {
+        LegacyDate l = legacyFromY2k(worst[i] - (i & 1));
+        benchSink += l.d + l.m + l.yOff;
+    });
+    return 0;
+}
@@ -0,0 +1,88 @@
+// DateTime::format() and the addToString() built on it against the
+// String-based addToString() they replaced. The host String is a
+// std::string, so this shows the formatting work rather than the AVR heap.
+
+#include <Sodaq_DS3231.h>
+#include "HostBench.h"
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+// The v1.3.5 addToString(), one String append per digit and separator
+static void add0Nd(String &str, uint16_t val, size_t width)
+{
+    if (width >= 5 && val < 1000)
+        str += '0';
+    if (width >= 4 && val < 100)
+        str += '0';
+    if (width >= 3 && val < 100)
+        str += '0';
+    if (width >= 2 && val < 10)
+        str += '0';
+    str += val;
+}
+
+static void legacyAddToString(String &str, const DateTime &dt)
+{
+    add0Nd(str, dt.year(), 4);
+    str += '-';
+    add0Nd(str, dt.month(), 2);
+    str += '-';
+    add0Nd(str, dt.date(), 2);
+    str += ' ';
+    add0Nd(str, dt.hour(), 2);
+    str += ':';
+    add0Nd(str, dt.minute(), 2);
+    str += ':';
+    add0Nd(str, dt.second(), 2);
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t last = DateTime(2099, 12, 31, 23, 59, 59, 5).get();
+    uint32_t state = 2463534242UL;
+    std::vector<DateTime> dates(1024);
+    for (size_t i = 0; i < dates.size(); i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        dates[i] = DateTime(i == 0 ? 0 : i == 1 ? last : state % (last + 1));
+    }
+
+    // Every input formats as it did
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < dates.size(); i++) {
+        String legacy, now;
+        legacyAddToString(legacy, dates[i]);
+        dates[i].addToString(now);
+        char buf[DT_FMT_MAX_LEN + 1];
+        dates[i].format(buf, sizeof(buf));
+        if (!(now == legacy.c_str()) || !(legacy == buf)) {
+            if (mismatches++ < 10)
+                printf("mismatch: %s %s %s\n", legacy.c_str(), now.c_str(), buf);
+        }
+    }
+    if (mismatches)
+        return 1;
+    if (benchCheckOnly(argc, argv))
+        return 0;
+
+    benchHeader();
+    bench("format()", dates.size(), 2000, [&](uint32_t i) {
+        char buf[DT_FMT_MAX_LEN + 1];
+        benchSink += dates[i].format(buf, sizeof(buf)) + buf[18];
+    });
+    bench("addToString()", dates.size(), 2000, [&](uint32_t i) {
+        String str;
+        str.reserve(DT_FMT_MAX_LEN);
+        dates[i].addToString(str);
+        benchSink += str.length();
+    });
+    bench("legacy addToString()", dates.size(), 2000, [&](uint32_t i) {
+        String str;
+        str.reserve(DT_FMT_MAX_LEN);
+        legacyAddToString(str, dates[i]);
+        benchSink += str.length();
+    });
+    return 0;
+}
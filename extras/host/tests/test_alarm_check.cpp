@@ -0,0 +1,58 @@
+// enableInterruptsCheckAlm1()/Alm2() report each alarm register that
+// differs from the periodic setting, and every one they couldn't read.
+
+#include <Sodaq_DS3231.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+
+static void testAlarm1()
+{
+    CHECK_EQ(rtc.enableInterrupts(EverySecond), DS3231_OK);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EverySecond), 0);
+    // Seconds register 0x80 where EveryMinute wants 0x00
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EveryMinute), 0x02);
+
+    for (uint8_t r = 0x07; r <= 0x0A; r++)
+        sim.setReg(r, 0x55);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EverySecond), 0x1E);
+    sim.setReg(0x0A, 0x80);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EverySecond), 0x0E);
+
+    sim.setReg(0x0E, 0x1C);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EverySecond), 0x0F);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(0x7F), 0xFF);
+}
+
+static void testAlarm2()
+{
+    rtc.enableInterruptsAlm2(EveryMinute);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm2(EveryMinute), 0);
+    sim.setReg(0x0B, 0x55);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm2(EveryMinute), 0x04);
+}
+
+static void testNotRead()
+{
+    rtc.enableInterrupts(EverySecond);
+    sim.setPresent(false);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm1(EverySecond), 0x1F);
+    CHECK_EQ(rtc.lastStatus(), DS3231_NACK);
+    CHECK_EQ(rtc.enableInterruptsCheckAlm2(EveryMinute), 0x1D);
+    sim.setPresent(true);
+}
+
+int main()
+{
+    sim.attach();
+    sim.powerOn();
+    rtc.begin();
+    testAlarm1();
+    testAlarm2();
+    testNotRead();
+    return hostTestResult();
+}
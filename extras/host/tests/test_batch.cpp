@@ -0,0 +1,99 @@
+// DateTimeBatch: every element as DateTime(long), serial and split across
+// threads, for lengths around the slice size and unaligned arrays.
+
+#include <Sodaq_DateTimeBatch.h>
+#include "HostTest.h"
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+struct Columns {
+    explicit Columns(size_t n)
+        : year(n + 1), month(n + 1), date(n + 1), hour(n + 1), minute(n + 1),
+          second(n + 1), wday(n + 1) {}
+    // One element in, so the columns aren't aligned as allocated
+    DateTimeColumns cols()
+    {
+        DateTimeColumns c = { &year[1], &month[1], &date[1], &hour[1], &minute[1],
+                              &second[1], &wday[1] };
+        return c;
+    }
+    std::vector<uint16_t> year;
+    std::vector<uint8_t> month, date, hour, minute, second, wday;
+};
+
+static uint32_t rngState = 2463534242UL;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// Count the elements that differ from DateTime(long)
+static size_t mismatches(const std::vector<uint32_t> &y2k, const DateTimeColumns &c)
+{
+    size_t bad = 0;
+    for (size_t i = 0; i < y2k.size(); i++) {
+        DateTime dt(y2k[i]);
+        if (c.year[i] != dt.year() || c.month[i] != dt.month() || c.date[i] != dt.date()
+                || c.hour[i] != dt.hour() || c.minute[i] != dt.minute()
+                || c.second[i] != dt.second() || c.dayOfWeek[i] != dt.dayOfWeek())
+            bad++;
+    }
+    return bad;
+}
+
+static void testConvert(size_t n)
+{
+    // Until 2135, the range of DateTime(long)
+    const uint32_t last = DateTime(2135, 12, 31, 23, 59, 59, 2).get();
+    std::vector<uint32_t> y2k(n);
+    for (size_t i = 0; i < n; i++)
+        y2k[i] = i == 0 ? 0 : i == 1 ? last : rng() % (last + 1);
+
+    Columns serial(n);
+    DateTimeBatch::fromY2k(y2k.data(), n, serial.cols());
+    CHECK_EQ(mismatches(y2k, serial.cols()), 0);
+
+    static const unsigned threads[] = { 0, 1, 2, 3, 8 };
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        Columns par(n);
+        DateTimeBatch::fromY2kParallel(y2k.data(), n, par.cols(), threads[t]);
+        CHECK_EQ(mismatches(y2k, par.cols()), 0);
+    }
+
+    // Unix times, with those before 2000 clamped as makeDateTime()
+    std::vector<uint32_t> epoch(n), expected(n);
+    for (size_t i = 0; i < n; i++) {
+        epoch[i] = i % 5 == 0 ? (uint32_t)(rng() % EPOCH_TIME_OFF) : y2k[i] % (0xFFFFFFFFUL - EPOCH_TIME_OFF) + EPOCH_TIME_OFF;
+        expected[i] = epoch[i] < EPOCH_TIME_OFF ? 0 : epoch[i] - EPOCH_TIME_OFF;
+    }
+    Columns fromEpoch(n);
+    DateTimeBatch::fromEpochParallel(epoch.data(), n, fromEpoch.cols(), 3);
+    CHECK_EQ(mismatches(expected, fromEpoch.cols()), 0);
+
+    // Text, record for record as format()
+    const size_t stride = DT_FMT_MAX_LEN + 2;
+    std::vector<char> text(n * stride + 1);
+    CHECK_EQ(DateTimeBatch::formatY2kParallel(y2k.data(), n, DT_FMT_ISO8601_TZ, &text[1], stride, 3), 20);
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        char buf[DT_FMT_MAX_LEN + 1];
+        DateTime(y2k[i]).format(buf, sizeof(buf), DT_FMT_ISO8601_TZ);
+        bad += strcmp(buf, &text[1 + i * stride]) != 0;
+    }
+    CHECK_EQ(bad, 0);
+}
+
+int main()
+{
+    static const size_t sizes[] = { 0, 1, 2, DT_BATCH_CHUNK - 1, DT_BATCH_CHUNK,
+                                    DT_BATCH_CHUNK + 1, 3 * DT_BATCH_CHUNK + 5, 100003 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        testConvert(sizes[i]);
+    CHECK_EQ(DateTimeBatch::formatY2k(0, 0, DT_FMT_ISO8601, 0, DT_FMT_MAX_LEN), 19);
+    CHECK_EQ(DateTimeBatch::formatY2kParallel(0, 0, DT_FMT_ISO8601_TZ, 0, 20), 0);
+    return hostTestResult();
+}
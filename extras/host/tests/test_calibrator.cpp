@@ -0,0 +1,89 @@
+// RtcCalibrator against a simulated DS3231 whose crystal runs 3 ppm fast,
+// with the host clock as the reference.
+
+#include <Sodaq_RtcCalibrator.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+static RtcCalibrator cal(rtc);
+
+static uint32_t baseY2k;
+static uint64_t baseUs;
+
+// The true time as Unix seconds and milliseconds
+static uint32_t refEpoch(uint16_t &ms)
+{
+    uint64_t us = hostMicros() - baseUs;
+    ms = (us / 1000) % 1000;
+    return baseY2k + EPOCH_TIME_OFF + (uint32_t)(us / 1000000);
+}
+
+static void takeSamples(bool cached)
+{
+    cal.clear();
+    sim.setReg(0x10, 0);
+    rtc.convertTemperature();
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    baseUs = hostMicros();
+    baseY2k = sim.y2k();
+    if (cached)
+        rtc.enableClockCache();
+    else
+        rtc.disableClockCache();
+
+    // Every 6 hours, at any point of the second; 3 ppm is 0.26 s a day
+    for (uint8_t i = 0; i < SODAQ_CAL_SAMPLES; i++) {
+        uint16_t ms;
+        uint32_t epoch = refEpoch(ms);
+        CHECK(cal.sample(epoch, ms));
+        hostAdvanceUs(6 * 3600000000ULL + 123457);
+    }
+    float ppm = 0;
+    CHECK(cal.estimatePpm(ppm));
+    CHECK(ppm > 2.9f && ppm < 3.1f);
+}
+
+static void testApply()
+{
+    CHECK(cal.apply());
+    CHECK_EQ(cal.count(), 0);
+    CHECK_EQ((int8_t)sim.reg(0x10), 30);
+    hostAdvanceUs(200000);
+    CHECK(sim.effectivePpm() > -0.1f && sim.effectivePpm() < 0.1f);
+}
+
+// A failed aging offset read leaves the register and the samples alone
+static void testApplyFails()
+{
+    takeSamples(false);
+    sim.setPresent(false);
+    CHECK(!cal.apply());
+    sim.setPresent(true);
+    CHECK_EQ(cal.count(), SODAQ_CAL_SAMPLES);
+    CHECK_EQ(sim.reg(0x10), 0);
+
+    uint16_t ms;
+    uint32_t epoch = refEpoch(ms);
+    sim.setPresent(false);
+    CHECK(!cal.sample(epoch, ms));
+    sim.setPresent(true);
+    CHECK_EQ(cal.count(), SODAQ_CAL_SAMPLES);
+}
+
+int main()
+{
+    sim.attach();
+    sim.powerOn();
+    sim.setPpm(3);
+    rtc.begin();
+    takeSamples(false);
+    testApply();
+    takeSamples(true);
+    testApply();
+    testApplyFails();
+    return hostTestResult();
+}
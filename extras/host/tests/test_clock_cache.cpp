@@ -0,0 +1,94 @@
+// The cached clock: resyncs from the 1 Hz edge, and a single read with no
+// wait when the cache expires without one.
+
+#include <Sodaq_DS3231.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+#define SQW_IRQ 2
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+
+static void onEdge()
+{
+    rtc.clockEdge();
+}
+
+// Milliseconds into the current RTC second
+static uint16_t simMs()
+{
+    return (uint16_t)((hostMicros() - (sim.nextSecondUs() - 1000000)) / 1000);
+}
+
+// Without an edge, an expired cache reads the time once instead of waiting
+// for the seconds rollover
+static void testNoEdge()
+{
+    rtc.enableClockCache(5000);
+    hostAdvanceUs(400000);
+    Wire.resetCounters();
+    uint64_t start = hostMicros();
+    uint32_t y2k = rtc.now().get();
+    CHECK_EQ(y2k, sim.y2k());
+    CHECK_EQ(Wire.counters().requests, 1);
+    CHECK(hostMicros() - start < 5000);
+
+    // Served from the cache until it expires, then one read again; the
+    // phase taken from that read stays
+    Wire.resetCounters();
+    hostAdvanceUs(3000000);
+    CHECK_EQ(rtc.now().get(), sim.y2k());
+    CHECK_EQ(Wire.counters().requests, 0);
+    hostAdvanceUs(3000000);
+    start = hostMicros();
+    uint16_t ms;
+    CHECK_EQ(rtc.getEpochMs(ms), sim.y2k() + EPOCH_TIME_OFF);
+    CHECK_EQ(Wire.counters().requests, 1);
+    CHECK(hostMicros() - start < 5000);
+}
+
+// An edge restores the millisecond phase, and the next expiry without edges
+// keeps it while the seconds agree
+static void testEdge()
+{
+    attachInterrupt(SQW_IRQ, onEdge, FALLING);
+    hostAdvanceUs(sim.nextSecondUs() - hostMicros() + 250000);
+    uint16_t ms;
+    CHECK_EQ(rtc.getEpochMs(ms), sim.y2k() + EPOCH_TIME_OFF);
+    CHECK(abs((int)ms - (int)simMs()) <= 1);
+    detachInterrupt(SQW_IRQ);
+
+    hostAdvanceUs(6300000);
+    Wire.resetCounters();
+    uint64_t start = hostMicros();
+    CHECK_EQ(rtc.getEpochMs(ms), sim.y2k() + EPOCH_TIME_OFF);
+    CHECK_EQ(Wire.counters().requests, 1);
+    CHECK(hostMicros() - start < 5000);
+    CHECK(abs((int)ms - (int)simMs()) <= 2);
+
+    // The RTC jumps: the read corrects the seconds, the next edge the phase
+    sim.setTime(2024, 3, 1, 12, 0, 0, 6);
+    hostAdvanceUs(5700000);
+    CHECK_EQ(rtc.now().get(), sim.y2k());
+    attachInterrupt(SQW_IRQ, onEdge, FALLING);
+    hostAdvanceUs(sim.nextSecondUs() - hostMicros() + 100000);
+    CHECK_EQ(rtc.getEpochMs(ms), sim.y2k() + EPOCH_TIME_OFF);
+    CHECK(abs((int)ms - (int)simMs()) <= 1);
+    detachInterrupt(SQW_IRQ);
+}
+
+int main()
+{
+    sim.attach();
+    sim.setIrq(SQW_IRQ);
+    sim.powerOn();
+    rtc.begin();
+    CHECK_EQ(rtc.setSquareWave(SQW_1HZ), DS3231_OK);
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    testNoEdge();
+    testEdge();
+    return hostTestResult();
+}
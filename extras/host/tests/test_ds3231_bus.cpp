@@ -0,0 +1,242 @@
+// Sodaq_DS3231 against the simulated DS3231: what each call puts on the
+// bus, the time keeping, alarms and the temperature conversion.
+
+#include <Sodaq_DS3231.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+
+static void resetCounters()
+{
+    Wire.resetCounters();
+    rtc.resetBusStats();
+}
+
+// Spend time until just after the next seconds update
+static void nextSecond()
+{
+    hostAdvanceUs(sim.nextSecondUs() - hostMicros() + 10);
+}
+
+// The driver's own counters agree with the bus
+static void checkStats()
+{
+    const HostI2cCounters &bus = Wire.counters();
+    const Sodaq_DS3231_BusStats &stats = rtc.getBusStats();
+    CHECK_EQ(stats.starts, bus.starts);
+    CHECK_EQ(stats.stops, bus.stops);
+    CHECK_EQ(stats.requests, bus.requests);
+    CHECK_EQ(stats.bytesWritten, bus.bytesWritten);
+    CHECK_EQ(stats.bytesRead, bus.bytesRead);
+}
+
+static void testBegin()
+{
+    sim.powerOn();
+    sim.setReg(0x0E, 0x00);
+    CHECK_EQ(rtc.begin(), 1);
+    CHECK_EQ(sim.reg(0x0E), 0x1C);
+    CHECK_EQ(rtc.lastStatus(), DS3231_OK);
+}
+
+// now() is one register pointer write and one 7 byte read
+static void testNowCost()
+{
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    resetCounters();
+    DateTime dt = rtc.now();
+    CHECK_EQ(dt.year(), 2024);
+    CHECK_EQ(dt.month(), 1);
+    CHECK_EQ(dt.date(), 5);
+    CHECK_EQ(dt.hour(), 1);
+    CHECK_EQ(dt.minute(), 2);
+    CHECK_EQ(dt.second(), 3);
+    CHECK_EQ(dt.dayOfWeek(), 6);
+
+    const HostI2cCounters &bus = Wire.counters();
+    CHECK_EQ(bus.starts, 2);
+    CHECK_EQ(bus.stops, 2);
+    CHECK_EQ(bus.transmissions, 1);
+    CHECK_EQ(bus.requests, 1);
+    CHECK_EQ(bus.bytesWritten, 1);
+    CHECK_EQ(bus.bytesRead, 7);
+    checkStats();
+    CHECK_EQ(rtc.getBusStats().api[DS3231_API_NOW].transactions, 1);
+    CHECK_EQ(rtc.getBusStats().api[DS3231_API_NOW].bytes, 8);
+}
+
+static void testTimeKeeping()
+{
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    delay(1500);
+    CHECK_EQ(rtc.now().second(), 4);
+
+    // Leap day, then the century bit at the end of 2099
+    sim.setTime(2024, 2, 28, 23, 59, 59, 4);
+    nextSecond();
+    DateTime dt = rtc.now();
+    CHECK_EQ(dt.month(), 2);
+    CHECK_EQ(dt.date(), 29);
+    CHECK_EQ(dt.dayOfWeek(), 5);
+
+    sim.setTime(2099, 12, 31, 23, 59, 59, 5);
+    nextSecond();
+    dt = rtc.now();
+    CHECK_EQ(dt.year(), 2100);
+    CHECK_EQ(dt.month(), 1);
+    CHECK_EQ(dt.date(), 1);
+    CHECK_EQ(dt.hour(), 0);
+    CHECK_EQ(dt.dayOfWeek(), 6);
+
+    // setEpoch() writes the registers in one burst and restarts the second
+    resetCounters();
+    CHECK_EQ(rtc.setEpoch(DateTime(2030, 6, 15, 12, 30, 45, 7).getEpoch()), DS3231_OK);
+    CHECK_EQ(Wire.counters().transmissions, 1);
+    CHECK_EQ(Wire.counters().bytesWritten, 8);
+    checkStats();
+    CHECK_EQ(sim.y2k(), DateTime(2030, 6, 15, 12, 30, 45, 7).get());
+    delay(999);
+    CHECK_EQ(rtc.now().second(), 45);
+    delay(2);
+    CHECK_EQ(rtc.now().second(), 46);
+}
+
+static void testAlarms()
+{
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    resetCounters();
+    CHECK_EQ(rtc.enableInterrupts(EverySecond), DS3231_OK);
+    CHECK_EQ(sim.reg(0x0E), 0x1D);
+    for (uint8_t r = 0x07; r <= 0x0A; r++)
+        CHECK_EQ(sim.reg(r), 0x80);
+    // Two write bursts, control then alarm 1, besides the reads
+    CHECK_EQ(Wire.counters().transmissions - Wire.counters().requests, 2);
+    checkStats();
+    CHECK_EQ(rtc.getBusStats().api[DS3231_API_ENABLE_INTERRUPTS].transactions, 2);
+    CHECK(!sim.intAsserted());
+    nextSecond();
+    CHECK(sim.intAsserted());
+    CHECK_EQ(sim.reg(0x0F) & 0x01, 0x01);
+    CHECK_EQ(rtc.clearINTStatus(), DS3231_OK);
+    CHECK(!sim.intAsserted());
+
+    // Date, hour, minute and second match, 5 s ahead
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    rtc.enableInterrupts(MATCH_DATE, 5, 1, 2, 8);
+    rtc.clearINTStatus();
+    for (uint8_t i = 0; i < 4; i++)
+        nextSecond();
+    CHECK(!sim.intAsserted());
+    nextSecond();
+    CHECK(sim.intAsserted());
+    rtc.clearINTStatus();
+    nextSecond();
+    CHECK(!sim.intAsserted());
+
+    CHECK_EQ(rtc.disableInterrupts(), DS3231_OK);
+    CHECK_EQ(sim.reg(0x0E), 0x1C);
+}
+
+static void testTemperature()
+{
+    sim.setAmbient(-11);    // -2.75 deg C
+    CHECK(rtc.startTemperatureConversion());
+    CHECK(sim.converting());
+    CHECK_EQ(sim.reg(0x0E) & 0x20, 0x20);
+    CHECK(!rtc.pollTemperature());
+    delay(130);
+    CHECK(rtc.pollTemperature());
+    CHECK_EQ(rtc.getTemperatureQuarters(), -11);
+
+    sim.setAmbient(101);
+    CHECK_EQ(rtc.convertTemperature(), DS3231_OK);
+    CHECK(rtc.getTemperature() == 25.25f);
+
+    // The cached temperature isn't served while a conversion is pending,
+    // and the completing poll brings it up to date
+    rtc.enableRegisterCache();
+    CHECK(rtc.refreshRegisters());
+    CHECK_EQ(rtc.getTemperatureQuarters(), 101);
+    sim.setAmbient(40);
+    CHECK_EQ(rtc.convertTemperature(false), DS3231_OK);
+    delay(130);
+    CHECK_EQ(rtc.getTemperatureQuarters(), 40);
+    CHECK(rtc.pollTemperature());
+    uint32_t requests = Wire.counters().requests;
+    CHECK_EQ(rtc.getTemperatureQuarters(), 40);
+    CHECK_EQ(Wire.counters().requests, requests);
+    rtc.enableRegisterCache(false);
+}
+
+// Reads inside a batch see what it staged, even with the register cache
+// enabled but not valid, and don't overwrite it from the device
+static void testBatchStaleCache()
+{
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    CHECK_EQ(rtc.disableInterrupts(), DS3231_OK);
+    for (uint8_t r = 0x07; r <= 0x0A; r++)
+        sim.setReg(r, 0x00);
+    rtc.enableRegisterCache();
+    rtc.invalidateRegisters();
+
+    // clearINTStatus() reads the status register after the alarm is staged
+    rtc.beginRegisterBatch();
+    rtc.enableInterrupts(EverySecond);
+    rtc.clearINTStatus();
+    rtc.commitRegisterBatch();
+    CHECK_EQ(rtc.lastStatus(), DS3231_OK);
+    CHECK_EQ(sim.reg(0x0E), 0x1D);
+    for (uint8_t r = 0x07; r <= 0x0A; r++)
+        CHECK_EQ(sim.reg(r), 0x80);
+
+    // disableAlarms() reads the control register enableInterrupts() staged
+    rtc.invalidateRegisters();
+    rtc.beginRegisterBatch();
+    rtc.enableInterrupts(MATCH_DATE, 5, 1, 2, 8);
+    rtc.disableAlarms();
+    rtc.commitRegisterBatch();
+    CHECK_EQ(sim.reg(0x0E), 0x1C);
+    CHECK_EQ(sim.reg(0x07), 0x08);
+    CHECK_EQ(sim.reg(0x0A), 0x05);
+
+    rtc.enableRegisterCache(false);
+}
+
+static void testFaults()
+{
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    resetCounters();
+    Wire.failNext(HOST_I2C_NACK_ADDRESS);
+    DateTime dt;
+    CHECK_EQ(rtc.now(dt), DS3231_OK);
+    CHECK_EQ(dt.date(), 5);
+    CHECK_EQ(rtc.getBusStats().retries, 1);
+    CHECK_EQ(Wire.counters().addressNacks, 1);
+
+    Wire.failNext(HOST_I2C_SHORT_READ, 10);
+    CHECK_EQ(rtc.now(dt), DS3231_SHORT_READ);
+    CHECK_EQ(dt.date(), 5);
+
+    sim.setPresent(false);
+    CHECK_EQ(rtc.now().get(), 0);
+    CHECK_EQ(rtc.lastStatus(), DS3231_NACK);
+    sim.setPresent(true);
+    Wire.failNext(HOST_I2C_NACK_ADDRESS, 0);
+}
+
+int main()
+{
+    sim.attach();
+    testBegin();
+    testNowCost();
+    testTimeKeeping();
+    testAlarms();
+    testTemperature();
+    testBatchStaleCache();
+    testFaults();
+    return hostTestResult();
+}
@@ -0,0 +1,123 @@
+// The driver and the classes built on it with the DS3231 on a second
+// TwoWire: every transfer goes to that bus, none to Wire.
+
+#include <Sodaq_DS3231_impl.h>
+#include <Sodaq_AlarmScheduler_impl.h>
+#include <Sodaq_RtcCalibrator_impl.h>
+#include <Sodaq_SubSecondClock_impl.h>
+#include <Sodaq_TemperatureHistory.h>
+#include <Sodaq_TimeSync_impl.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+TwoWire Wire1;
+
+typedef Sodaq_DS3231T<TwoWireBus<Wire1> > Rtc1;
+
+static SimDs3231 sim;
+static Rtc1 rtc;
+
+static uint8_t fired;
+
+static void onAlarm(uint8_t)
+{
+    fired++;
+}
+
+// Nothing on Wire, and something on Wire1
+static void checkBus()
+{
+    CHECK_EQ(Wire.counters().starts, 0);
+    CHECK(Wire1.counters().starts > 0);
+    Wire1.resetCounters();
+}
+
+static void testDriver()
+{
+    CHECK_EQ(rtc.begin(), 1);
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    CHECK_EQ(rtc.now().get(), sim.y2k());
+    CHECK_EQ(rtc.lastStatus(), DS3231_OK);
+    checkBus();
+}
+
+static void testScheduler()
+{
+    AlarmSchedulerT<Rtc1> scheduler(rtc);
+    uint8_t id = scheduler.add(5, onAlarm);
+    CHECK(id != SODAQ_ALARM_NONE);
+    CHECK_EQ(scheduler.nextDeadline(), sim.y2k() + 5);
+    checkBus();
+
+    hostAdvanceUs(5000000);
+    CHECK(sim.intAsserted());
+    CHECK_EQ(scheduler.dispatch(), 1);
+    CHECK_EQ(fired, 1);
+    CHECK(!sim.intAsserted());
+    CHECK_EQ(scheduler.remove(id), DS3231_OK);
+    checkBus();
+}
+
+static void testTemperatureAndCalibration()
+{
+    sim.setAmbient(101);
+    CHECK_EQ(rtc.convertTemperature(), DS3231_OK);
+    TemperatureHistory<4> history;
+    CHECK(history.sample(rtc));
+    CHECK_EQ(history.newest().quarters, 101);
+    checkBus();
+
+    RtcCalibratorT<Rtc1> cal(rtc);
+    CHECK(cal.sample(sim.y2k() + EPOCH_TIME_OFF, 0));
+    CHECK_EQ(cal.count(), 1);
+    CHECK_EQ(cal.meanTemperatureQuarters(), 101);
+    checkBus();
+}
+
+static void testSubSecond()
+{
+    SubSecondClockT<Rtc1> ssc(rtc);
+    ssc.begin();
+    CHECK_EQ(sim.reg(0x0E) & 0x1C, 0);     // 1 Hz square wave, INTCN off
+    uint32_t us;
+    CHECK_EQ(ssc.getEpochUs(us), sim.y2k() + EPOCH_TIME_OFF);
+    CHECK_EQ(us, 0);
+    checkBus();
+}
+
+static void testTimeSync()
+{
+    HostStream port;
+    TimeSyncResponderT<Rtc1> responder(rtc, port);
+    uint8_t frame[TSYNC_FRAME_LEN];
+    frame[0] = TSYNC_SOF;
+    frame[1] = TSYNC_READ;
+    frame[2] = TSYNC_PAYLOAD_LEN;
+    memset(&frame[3], 0, TSYNC_PAYLOAD_LEN);
+    uint16_t crc = TimeSyncResponderT<Rtc1>::crc16(&frame[1], 2 + TSYNC_PAYLOAD_LEN);
+    frame[TSYNC_FRAME_LEN - 2] = crc >> 8;
+    frame[TSYNC_FRAME_LEN - 1] = crc;
+    port.feed(frame, sizeof(frame));
+    CHECK_EQ(responder.poll(), TSYNC_READ);
+    CHECK_EQ(port.tx.size(), TSYNC_FRAME_LEN);
+    // The reply names the second that just began
+    uint32_t epoch = 0;
+    for (uint8_t i = 0; i < 4; i++)
+        epoch |= (uint32_t)port.tx[3 + i] << (8 * i);
+    CHECK_EQ(epoch, sim.y2k() + EPOCH_TIME_OFF);
+    checkBus();
+}
+
+int main()
+{
+    sim.attach(Wire1);
+    sim.powerOn();
+    testDriver();
+    testScheduler();
+    testTemperatureAndCalibration();
+    testSubSecond();
+    testTimeSync();
+    return hostTestResult();
+}
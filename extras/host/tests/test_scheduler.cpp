@@ -0,0 +1,122 @@
+// AlarmScheduler on the simulated DS3231: what is programmed into Alarm 1
+// as timers come and go.
+
+#include <Sodaq_AlarmScheduler.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+static AlarmScheduler scheduler(rtc);
+static uint8_t fired[SODAQ_ALARM_SLOTS];
+
+static void onAlarm(uint8_t id)
+{
+    fired[id]++;
+}
+
+static uint8_t bcd(uint8_t v)
+{
+    return (v / 10) << 4 | v % 10;
+}
+
+// Alarm 1 matches date, hour, minute and second of y2k
+static bool alarm1At(uint32_t y2k)
+{
+    DateTime dt((long)y2k);
+    return sim.reg(0x07) == bcd(dt.second()) && sim.reg(0x08) == bcd(dt.minute())
+        && sim.reg(0x09) == bcd(dt.hour()) && sim.reg(0x0A) == bcd(dt.date())
+        && (sim.reg(0x0E) & 0x05) == 0x05;
+}
+
+// Removing the nearest timer programs the next one, removing the last one
+// turns Alarm 1 off with a single control register update
+static void testRemove()
+{
+    uint32_t now = sim.y2k();
+    uint8_t a = scheduler.add(10, onAlarm, now + 5);
+    uint8_t b = scheduler.add(100, onAlarm);
+    CHECK(alarm1At(now + 5));
+
+    scheduler.remove(a);
+    CHECK_EQ(scheduler.count(), 1);
+    CHECK(alarm1At(now + 100));
+
+    Wire.resetCounters();
+    uint64_t start = hostMicros();
+    scheduler.remove(b);
+    CHECK_EQ(scheduler.count(), 0);
+    CHECK_EQ(sim.reg(0x0E) & 0x03, 0);
+    CHECK_EQ(sim.reg(0x0E) & 0x04, 0x04);
+    CHECK(hostMicros() - start < 5000);
+    // Only the control register read and write, no time is needed
+    CHECK_EQ(Wire.counters().transmissions, 2);
+
+    // Nothing fires any more
+    hostAdvanceUs(6000000);
+    CHECK(!sim.intAsserted());
+}
+
+// A first deadline in the past fires one second from now, not next month
+static void testPastDeadline()
+{
+    uint32_t now = sim.y2k();
+    uint8_t id = scheduler.add(0, onAlarm, now - 30);
+    CHECK_EQ(scheduler.nextDeadline(), now + 1);
+    CHECK(alarm1At(now + 1));
+    hostAdvanceUs(sim.nextSecondUs() - hostMicros() + 10);
+    CHECK(sim.intAsserted());
+    CHECK_EQ(scheduler.dispatch(), 1);
+    CHECK_EQ(fired[id], 1);
+    CHECK_EQ(scheduler.count(), 0);
+    CHECK(!sim.intAsserted());
+    CHECK_EQ(sim.reg(0x0E) & 0x01, 0);
+}
+
+// Nothing is programmed from a time that couldn't be read
+static void testReadFailure()
+{
+    uint32_t now = sim.y2k();
+    uint8_t a = scheduler.add(0, onAlarm, now + 3);
+    uint8_t b = scheduler.add(0, onAlarm, now + 60);
+    uint8_t firedA = fired[a];
+    CHECK(alarm1At(now + 3));
+
+    sim.setPresent(false);
+    CHECK_EQ(scheduler.add(10, onAlarm), SODAQ_ALARM_NONE);
+    CHECK_EQ(scheduler.count(), 2);
+    CHECK_EQ(scheduler.remove(a), DS3231_NACK);
+    CHECK_EQ(scheduler.count(), 1);
+    sim.setPresent(true);
+    CHECK(alarm1At(now + 3));
+
+    // The old deadline fires; while the RTC is away the flag stays set
+    hostAdvanceUs(3000000);
+    CHECK(sim.intAsserted());
+    sim.setPresent(false);
+    CHECK_EQ(scheduler.dispatch(), 0);
+    sim.setPresent(true);
+    CHECK(sim.intAsserted());
+    CHECK(alarm1At(now + 3));
+
+    // and the next dispatch() moves on to b
+    CHECK_EQ(scheduler.dispatch(), 0);
+    CHECK(!sim.intAsserted());
+    CHECK(alarm1At(now + 60));
+    CHECK_EQ(scheduler.remove(b), DS3231_OK);
+    CHECK_EQ(fired[a], firedA);
+}
+
+int main()
+{
+    sim.attach();
+    sim.powerOn();
+    rtc.begin();
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    testRemove();
+    testPastDeadline();
+    testReadFailure();
+    return hostTestResult();
+}
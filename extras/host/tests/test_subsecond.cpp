@@ -0,0 +1,70 @@
+// SubSecondClock on the simulated 1 Hz square wave: naming the second of
+// an edge, and a failed read while doing so.
+
+#include <Sodaq_SubSecondClock.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+#define SQW_IRQ 2
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+static SubSecondClock ssc(rtc);
+
+static void onEdge()
+{
+    ssc.edge();
+}
+
+// Spend time until us after the next seconds update
+static void afterEdge(uint32_t us)
+{
+    hostAdvanceUs(sim.nextSecondUs() - hostMicros() + us);
+}
+
+static void testAnchor()
+{
+    afterEdge(1000);
+    sim.setPresent(false);
+    uint32_t us;
+    ssc.getEpochUs(us);
+    sim.setPresent(true);
+    // A failed read names no second, and is only tried again on the next edge
+    CHECK(!ssc.synced());
+    CHECK_EQ(rtc.lastStatus(), DS3231_NACK);
+    Wire.resetCounters();
+    hostAdvanceUs(100000);
+    ssc.getEpochUs(us);
+    CHECK(!ssc.synced());
+    CHECK_EQ(Wire.counters().requests, 1);  // The fallback now() only
+
+    afterEdge(250000);
+    uint32_t epoch = ssc.getEpochUs(us);
+    CHECK(ssc.synced());
+    CHECK_EQ(epoch, sim.y2k() + EPOCH_TIME_OFF);
+    CHECK(us >= 250000 && us < 255000);
+
+    // Counted from the edges afterwards, with no bus traffic
+    Wire.resetCounters();
+    afterEdge(600000);
+    epoch = ssc.getEpochUs(us);
+    CHECK_EQ(epoch, sim.y2k() + EPOCH_TIME_OFF);
+    CHECK(us >= 600000 && us < 601000);
+    CHECK_EQ(Wire.counters().requests, 0);
+    CHECK_EQ(ssc.edges(), 3);
+}
+
+int main()
+{
+    sim.attach();
+    sim.setIrq(SQW_IRQ);
+    sim.powerOn();
+    rtc.begin();
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    ssc.begin();
+    attachInterrupt(SQW_IRQ, onEdge, FALLING);
+    testAnchor();
+    return hostTestResult();
+}
@@ -0,0 +1,85 @@
+// TemperatureHistory: the window statistics, what an empty history
+// returns, and samples from the simulated DS3231.
+
+#include <Sodaq_TemperatureHistory.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+
+static void testEmpty()
+{
+    TemperatureHistory<4> history;
+    CHECK_EQ(history.count(), 0);
+    CHECK_EQ(history.minimum().quarters, TEMP_HISTORY_NO_SAMPLE);
+    CHECK_EQ(history.maximum().quarters, TEMP_HISTORY_NO_SAMPLE);
+    CHECK_EQ(history.newest().quarters, TEMP_HISTORY_NO_SAMPLE);
+    CHECK_EQ(history.minimum().y2k, 0);
+    CHECK_EQ(history.meanQuarters(), 0);
+
+    history.add(100, -11);
+    history.clear();
+    CHECK_EQ(history.minimum().quarters, TEMP_HISTORY_NO_SAMPLE);
+}
+
+// Minimum and maximum as the oldest samples leave the window
+static void testWindow()
+{
+    static const int16_t temps[] = { 100, 80, 120, 90, 90, 110, 70, 75 };
+    TemperatureHistory<4> history;
+    for (uint8_t i = 0; i < sizeof(temps) / sizeof(temps[0]); i++) {
+        history.add(1000 + i, temps[i]);
+        uint8_t first = i < 3 ? 0 : i - 3;
+        int16_t lo = temps[first], hi = temps[first];
+        int32_t sum = 0;
+        for (uint8_t j = first; j <= i; j++) {
+            lo = temps[j] < lo ? temps[j] : lo;
+            hi = temps[j] > hi ? temps[j] : hi;
+            sum += temps[j];
+        }
+        CHECK_EQ(history.minimum().quarters, lo);
+        CHECK_EQ(history.maximum().quarters, hi);
+        CHECK_EQ(history.meanQuarters(), sum / (i - first + 1));
+        CHECK_EQ(history.newest().y2k, 1000 + i);
+        CHECK_EQ(history.at(0).y2k, 1000 + first);
+    }
+}
+
+// A failed read adds nothing
+static void testSample()
+{
+    sim.attach();
+    sim.powerOn();
+    rtc.begin();
+    sim.setTime(2024, 1, 5, 1, 2, 3, 6);
+    sim.setAmbient(101);
+    rtc.convertTemperature();
+
+    TemperatureHistory<4> history;
+    CHECK(history.sample(rtc));
+    CHECK_EQ(history.count(), 1);
+    CHECK_EQ(history.newest().quarters, 101);
+    CHECK_EQ(history.newest().y2k, DateTime(2024, 1, 5, 1, 2, 3, 6).get());
+
+    sim.setPresent(false);
+    CHECK(!history.sample(rtc));
+    sim.setPresent(true);
+    Wire.failNext(HOST_I2C_SHORT_READ, 10);
+    CHECK(!history.sample(rtc));
+    Wire.failNext(HOST_I2C_NACK_ADDRESS, 0);
+    CHECK_EQ(history.count(), 1);
+    CHECK_EQ(history.minimum().quarters, 101);
+    CHECK_EQ(history.minimum().y2k, DateTime(2024, 1, 5, 1, 2, 3, 6).get());
+    CHECK_EQ(history.meanQuarters(), 101);
+}
+
+int main()
+{
+    testEmpty();
+    testWindow();
+    testSample();
+    return hostTestResult();
+}
@@ -0,0 +1,71 @@
+// TimeSyncResponder framing: bytes outside a frame, PING, and a frame of
+// an unknown type.
+
+#include <Sodaq_TimeSync.h>
+#include "SimDs3231.h"
+#include "HostTest.h"
+
+using namespace sodaq_DS3231_nm;
+
+static SimDs3231 sim;
+static Sodaq_DS3231 rtc;
+static HostStream port;
+static TimeSyncResponder responder(rtc, port);
+
+static void sendFrame(uint8_t type, uint8_t fill)
+{
+    uint8_t frame[TSYNC_FRAME_LEN];
+    frame[0] = TSYNC_SOF;
+    frame[1] = type;
+    frame[2] = TSYNC_PAYLOAD_LEN;
+    memset(&frame[3], fill, TSYNC_PAYLOAD_LEN);
+    uint16_t crc = TimeSyncResponder::crc16(&frame[1], 2 + TSYNC_PAYLOAD_LEN);
+    frame[TSYNC_FRAME_LEN - 2] = crc >> 8;
+    frame[TSYNC_FRAME_LEN - 1] = crc;
+    port.feed(frame, sizeof(frame));
+}
+
+// Text nobody reads is dropped, and the frame after it answered
+static void testNoise()
+{
+    const char text[] = "T1704416523\n";
+    port.feed((const uint8_t *)text, sizeof(text) - 1);
+    CHECK_EQ(responder.poll(), 0);
+    CHECK_EQ(port.available(), 0);
+
+    port.feed((const uint8_t *)text, sizeof(text) - 1);
+    sendFrame(TSYNC_PING, 0x11);
+    CHECK_EQ(responder.poll(), TSYNC_PING);
+    CHECK_EQ(port.available(), 0);
+    CHECK_EQ(port.tx.size(), TSYNC_FRAME_LEN);
+    if (port.tx.size() != TSYNC_FRAME_LEN)
+        return;
+    CHECK_EQ(port.tx[0], TSYNC_SOF);
+    CHECK_EQ(port.tx[1], TSYNC_PING | TSYNC_REPLY);
+    CHECK_EQ(port.tx[3], 0x11);
+    port.tx.clear();
+}
+
+// A well formed frame of an unknown type is neither answered nor reported
+static void testUnknownType()
+{
+    sendFrame(0x07, 0);
+    CHECK_EQ(responder.poll(), 0);
+    CHECK_EQ(port.tx.size(), 0);
+
+    // A bad CRC neither
+    sendFrame(TSYNC_PING, 0);
+    port.rx[5] ^= 1;
+    CHECK_EQ(responder.poll(), 0);
+    CHECK_EQ(port.tx.size(), 0);
+}
+
+int main()
+{
+    sim.attach();
+    sim.powerOn();
+    rtc.begin();
+    testNoise();
+    testUnknownType();
+    return hostTestResult();
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Round trip of extras/tsdecode.py against TimestampEncoder:
+
+    python3 test_tsdecode.py path/to/ts_stream
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+# tsdecode.py is in extras, two levels up
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+import tsdecode
+
+# The columns of expected.tsv after the y2k seconds
+COLUMNS = ["iso8601", "iso8601-t", "iso8601-tz", "compact", "csv", "epoch"]
+
+
+def expect_error(data):
+    try:
+        list(tsdecode.decode(data))
+    except ValueError:
+        return True
+    return False
+
+
+def main():
+    failures = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        subprocess.check_call([sys.argv[1], tmp])
+        with open(os.path.join(tmp, "stream.bin"), "rb") as f:
+            data = f.read()
+        with open(os.path.join(tmp, "expected.tsv")) as f:
+            expected = [line.rstrip("\n").split("\t") for line in f]
+
+    decoded = list(tsdecode.decode(data))
+    if decoded != [int(row[0]) for row in expected]:
+        print("decoded seconds differ")
+        failures += 1
+    for row, y2k in zip(expected, decoded):
+        for fmt, text in zip(COLUMNS, row[1:]):
+            if tsdecode.format_time(y2k, fmt) != text:
+                print("%d as %s: %s, expected %s" % (y2k, fmt, tsdecode.format_time(y2k, fmt), text))
+                failures += 1
+
+    # Where TimestampDecoder stops
+    if not expect_error(bytes([0x3D])):
+        print("delta before a keyframe not reported")
+        failures += 1
+    if not expect_error(data[:3]):
+        print("truncated keyframe not reported")
+        failures += 1
+    if not expect_error(bytes([0, 1, 0, 0, 0, 0x81])):
+        print("truncated delta not reported")
+        failures += 1
+    if not expect_error(bytes([0, 1, 0, 0, 0, 0x81, 0x81, 0x81, 0x01])):
+        print("4 byte delta not reported")
+        failures += 1
+
+    if failures:
+        print("%d checks failed" % failures)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,75 @@
+// Writes a TimestampEncoder stream and what each timestamp should decode
+// to, for test_tsdecode.py:
+//
+//   ts_stream DIR    writes DIR/stream.bin and DIR/expected.tsv
+//
+// Each line of expected.tsv is the y2k seconds, the five DateTime::format()
+// layouts and the Unix time, separated by tabs.
+
+#include <Sodaq_DS3231.h>
+#include <Sodaq_TimestampCodec.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace sodaq_DS3231_nm;
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s DIR\n", argv[0]);
+        return 2;
+    }
+
+    // A logger sampling every 60 s with some jitter, a gap of a day, a clock
+    // set backwards, a jump past the largest delta, and the end of the range
+    std::vector<uint32_t> times;
+    uint32_t t = DateTime(2024, 1, 5, 1, 2, 3, 6).get();
+    for (int i = 0; i < 300; i++) {
+        times.push_back(t);
+        t += 60 + (i % 7 == 3 ? 1 : 0) - (i % 11 == 5 ? 1 : 0);
+    }
+    times.push_back(t + 86400);
+    times.push_back(t + 86400 + 200);
+    times.push_back(t + 86400 + 20000);
+    times.push_back(t);
+    times.push_back(t + 1);
+    times.push_back(t + 1);
+    times.push_back(t + 1 + TS_CODEC_MAX_DELTA);
+    times.push_back(t + 2 + 2 * TS_CODEC_MAX_DELTA);
+    times.push_back(DateTime(2099, 12, 31, 23, 59, 59, 5).get());
+    times.push_back(DateTime(2100, 3, 1, 0, 0, 0, 2).get());
+    times.push_back(0xFFFFFFFFUL);
+
+    TimestampEncoder enc(64);
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < times.size(); i++) {
+        if (i == 150)
+            enc.forceKeyframe();
+        uint8_t buf[TS_CODEC_MAX_LEN];
+        uint8_t len = enc.encode(times[i], buf);
+        stream.insert(stream.end(), buf, buf + len);
+    }
+
+    std::string dir = argv[1];
+    FILE *f = fopen((dir + "/stream.bin").c_str(), "wb");
+    if (!f || fwrite(stream.data(), 1, stream.size(), f) != stream.size())
+        return 1;
+    fclose(f);
+
+    f = fopen((dir + "/expected.tsv").c_str(), "w");
+    if (!f)
+        return 1;
+    for (size_t i = 0; i < times.size(); i++) {
+        DateTime dt(times[i]);
+        fprintf(f, "%lu", (unsigned long)times[i]);
+        for (uint8_t fmt = DT_FMT_ISO8601; fmt <= DT_FMT_CSV; fmt++) {
+            char buf[DT_FMT_MAX_LEN + 1];
+            dt.format(buf, sizeof(buf), (DateTimeFormat_t)fmt);
+            fprintf(f, "\t%s", buf);
+        }
+        fprintf(f, "\t%llu\n", (unsigned long long)times[i] + EPOCH_TIME_OFF);
+    }
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Decodes a timestamp stream written by TimestampEncoder
+(Sodaq_TimestampCodec.h) into one date and time per line.
+
+    python tsdecode.py TIMES.BIN
+    python tsdecode.py TIMES.BIN --format epoch -o times.txt
+
+The stream holds only timestamps: a keyframe is 0x00 and the 32-bit
+seconds since 2000-01-01, little endian; anything else is a delta, the
+seconds since the previous timestamp plus one as an unsigned LEB128
+varint of 1 to 3 bytes. The default format is the one of
+DateTime::format() and addToString(), e.g. 2024-01-05 01:02:03.
+"""
+
+import argparse
+import datetime
+import sys
+
+Y2K = datetime.datetime(2000, 1, 1)
+EPOCH_TIME_OFF = 946684800
+
+KEYFRAME = 0x00
+MAX_VARINT_LEN = 3
+
+# The DateTimeFormat_t layouts, and plain numbers
+FORMATS = {
+    "iso8601": "%Y-%m-%d %H:%M:%S",
+    "iso8601-t": "%Y-%m-%dT%H:%M:%S",
+    "iso8601-tz": "%Y-%m-%dT%H:%M:%SZ",
+    "compact": "%Y%m%d%H%M%S",
+    "csv": "%Y-%m-%d,%H:%M:%S",
+    "epoch": None,
+    "y2k": None,
+}
+
+
+def decode(data):
+    """Yields the seconds since 2000 of each timestamp in data.
+
+    Raises ValueError, after the timestamps before it, on a truncated
+    timestamp or a delta ahead of the first keyframe, where
+    TimestampDecoder stops.
+    """
+    last = None
+    pos = 0
+    while pos < len(data):
+        if data[pos] == KEYFRAME:
+            if pos + 5 > len(data):
+                raise ValueError("truncated keyframe at byte %d" % pos)
+            last = int.from_bytes(data[pos + 1:pos + 5], "little")
+            pos += 5
+        else:
+            if last is None:
+                raise ValueError("delta before the first keyframe at byte %d" % pos)
+            value = 0
+            for i in range(MAX_VARINT_LEN):
+                if pos + i >= len(data):
+                    raise ValueError("truncated delta at byte %d" % pos)
+                byte = data[pos + i]
+                value |= (byte & 0x7F) << (7 * i)
+                if not byte & 0x80:
+                    break
+            else:
+                raise ValueError("delta longer than %d bytes at byte %d" % (MAX_VARINT_LEN, pos))
+            last = (last + value - 1) & 0xFFFFFFFF
+            pos += i + 1
+        yield last
+
+
+def to_datetime(y2k):
+    """Naive UTC datetime of seconds since 2000, as DateTime(long)."""
+    return Y2K + datetime.timedelta(seconds=y2k)
+
+
+def format_time(y2k, fmt="iso8601"):
+    if fmt == "y2k":
+        return str(y2k)
+    if fmt == "epoch":
+        return str(y2k + EPOCH_TIME_OFF)
+    return to_datetime(y2k).strftime(FORMATS[fmt])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("stream", help="timestamp stream file")
+    parser.add_argument("--format", choices=sorted(FORMATS), default="iso8601",
+                        help="output format (default iso8601, as addToString())")
+    parser.add_argument("-o", "--output", help="text file to write (default standard output)")
+    args = parser.parse_args()
+
+    with open(args.stream, "rb") as f:
+        data = f.read()
+    out = open(args.output, "w") if args.output else sys.stdout
+    try:
+        for y2k in decode(data):
+            out.write(format_time(y2k, args.format) + "\n")
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.stream, e))
+    finally:
+        if args.output:
+            out.close()
+
+
+if __name__ == "__main__":
+    main()
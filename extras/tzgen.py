@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Writes a C++ header with the DST changes of a POSIX TZ string, for
+Sodaq_LocalTime.h.
+
+    python tzgen.py "EST5EDT,M3.2.0,M11.1.0" tzEastern > tz_eastern.h
+    python tzgen.py "CET-1CEST,M3.5.0,M10.5.0/3" tzCentralEurope --verify Europe/Berlin
+
+The header holds, for every year of the range, the UTC instants (seconds
+since 2000-01-01) at which DST starts and ends, in flash, and a TimeZone
+named after the second argument. Zones without DST get an empty table.
+
+The TZ string is the one the C library takes in the TZ environment
+variable, see tzset(3); the last line of an IANA zone file is one:
+    tail -n 1 /usr/share/zoneinfo/America/New_York
+A TZ string only has today's rules, and they are applied to every year
+of the range; start the range (--first) when they took effect, e.g. 2007
+for the US. --verify checks every change against the IANA zone of that
+name.
+"""
+
+import argparse
+import datetime
+import re
+import sys
+
+Y2K = datetime.datetime(2000, 1, 1)
+# 2136 is past the end of the 32 bit seconds the table holds
+LAST_YEAR = 2135
+
+NAME = r"(<[^>]+>|[A-Za-z]{3,})"
+OFFSET = r"([+-]?\d{1,3}(?::\d{1,2}){0,2})"
+TZ_RE = re.compile(
+    r"^" + NAME + OFFSET + r"(?:" + NAME + OFFSET + r"?"
+    r"(?:,([^,/]+)(?:/" + OFFSET + r")?,([^,/]+)(?:/" + OFFSET + r")?)?)?$")
+
+# POSIX leaves the rules of a DST name without rules to the implementation;
+# this is what glibc and the IANA "posixrules" file use.
+DEFAULT_RULES = ("M3.2.0", "M11.1.0")
+
+
+def seconds(text):
+    """[+-]hh[:mm[:ss]] to seconds"""
+    sign = -1 if text.startswith("-") else 1
+    parts = [int(p) for p in text.lstrip("+-").split(":")]
+    parts += [0] * (3 - len(parts))
+    return sign * (parts[0] * 3600 + parts[1] * 60 + parts[2])
+
+
+def is_leap(year):
+    return year % 4 == 0 and (year % 100 != 0 or year % 400 == 0)
+
+
+def rule_date(rule, year):
+    """The date a Jn, n or Mm.w.d rule gives in a year"""
+    jan1 = datetime.date(year, 1, 1)
+    if rule.startswith("J"):
+        # 1..365, February 29 is never counted
+        n = int(rule[1:])
+        if not 1 <= n <= 365:
+            raise ValueError("bad rule " + rule)
+        return jan1 + datetime.timedelta(n - 1 + (1 if is_leap(year) and n >= 60 else 0))
+    if rule.startswith("M"):
+        month, week, wday = (int(p) for p in rule[1:].split("."))
+        if not (1 <= month <= 12 and 1 <= week <= 5 and 0 <= wday <= 6):
+            raise ValueError("bad rule " + rule)
+        first = datetime.date(year, month, 1)
+        # isoweekday() is 1..7 from Monday, the rule's day 0..6 from Sunday
+        day = first + datetime.timedelta((wday - first.isoweekday() % 7) % 7 + 7 * (week - 1))
+        while day.month != month:
+            day -= datetime.timedelta(7)
+        return day
+    n = int(rule)
+    if not 0 <= n <= 365:
+        raise ValueError("bad rule " + rule)
+    return jan1 + datetime.timedelta(n)
+
+
+class Zone:
+    def __init__(self, tz):
+        m = TZ_RE.match(tz)
+        if not m:
+            raise ValueError("not a POSIX TZ string: " + tz)
+        std, std_off, dst, dst_off, start, start_time, end, end_time = m.groups()
+        self.std_name = std.strip("<>")
+        # POSIX offsets count west of UTC, ours east
+        self.std_minutes = -seconds(std_off) // 60
+        self.dst_name = dst.strip("<>") if dst else self.std_name
+        if dst is None:
+            self.dst_minutes = self.std_minutes
+        elif dst_off is None:
+            self.dst_minutes = self.std_minutes + 60
+        else:
+            self.dst_minutes = -seconds(dst_off) // 60
+        if dst is not None and start is None:
+            start, end = DEFAULT_RULES
+        self.rules = None
+        if dst is not None:
+            self.rules = ((start, seconds(start_time or "2")), (end, seconds(end_time or "2")))
+
+    def changes(self, year):
+        """DST start and end of a year in UTC seconds since 2000"""
+        (start, start_time), (end, end_time) = self.rules
+        # The start is given in standard time, the end in DST
+        start_at = datetime.datetime.combine(rule_date(start, year), datetime.time()) \
+            + datetime.timedelta(seconds=start_time - self.std_minutes * 60)
+        end_at = datetime.datetime.combine(rule_date(end, year), datetime.time()) \
+            + datetime.timedelta(seconds=end_time - self.dst_minutes * 60)
+        return [int((at - Y2K).total_seconds()) for at in (start_at, end_at)]
+
+
+def verify(zone, first, last, iana):
+    """Compare the offsets either side of every change with the IANA zone"""
+    from zoneinfo import ZoneInfo
+    tz = ZoneInfo(iana)
+    errors = 0
+    for year in range(first, last + 1):
+        start, end = zone.changes(year)
+        for at, before, after in ((start, zone.std_minutes, zone.dst_minutes),
+                                  (end, zone.dst_minutes, zone.std_minutes)):
+            for t, expect in ((at - 1, before), (at, after)):
+                utc = (Y2K + datetime.timedelta(seconds=t)).replace(tzinfo=datetime.timezone.utc)
+                got = int(utc.astimezone(tz).utcoffset().total_seconds()) // 60
+                if got != expect:
+                    print("%s: %d minutes, %s says %d" % (utc.isoformat(), expect, iana, got),
+                          file=sys.stderr)
+                    errors += 1
+    return errors
+
+
+def write_header(out, tz, name, zone, first, last):
+    years = last - first + 1 if zone.rules else 0
+    guard = re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name).upper() + "_H"
+    out.write("// Generated by extras/tzgen.py, do not edit.\n")
+    out.write("// TZ \"%s\", %d..%d\n\n" % (tz, first, last))
+    out.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    out.write("#include <Sodaq_LocalTime.h>\n\n")
+    out.write("// DST start and end per year, UTC seconds since 2000\n")
+    out.write("static const uint32_t %s_changes[] SODAQ_TZ_PROGMEM = {\n" % name)
+    for year in range(first, first + years):
+        start, end = zone.changes(year)
+        out.write("    %10dUL, %10dUL,     // %d\n" % (start, end, year))
+    if not years:
+        out.write("    0\n")
+    out.write("};\n\n")
+    out.write("static const sodaq_DS3231_nm::TimeZone %s = {\n" % name)
+    out.write("    %d, %d, %d, %d, %s_changes, \"%s\", \"%s\"\n"
+              % (zone.std_minutes, zone.dst_minutes, first, years, name,
+                 zone.std_name, zone.dst_name))
+    out.write("};\n\n#endif\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("tz", help='POSIX TZ string, e.g. "EST5EDT,M3.2.0,M11.1.0"')
+    parser.add_argument("name", help="C++ name of the TimeZone, e.g. tzEastern")
+    parser.add_argument("--first", type=int, default=2000, help="first year (default 2000)")
+    parser.add_argument("--last", type=int, default=2099,
+                        help="last year (default 2099, the DS3231 range)")
+    parser.add_argument("--verify", metavar="ZONE",
+                        help="check the changes against an IANA zone, e.g. America/New_York")
+    parser.add_argument("-o", "--output", help="header to write (default standard output)")
+    args = parser.parse_args()
+
+    if not re.match(r"^[A-Za-z_]\w*$", args.name):
+        parser.error("name must be a C++ identifier")
+    if not 2000 <= args.first <= args.last <= LAST_YEAR:
+        parser.error("years must be within 2000..%d" % LAST_YEAR)
+    try:
+        zone = Zone(args.tz)
+    except ValueError as e:
+        parser.error(str(e))
+
+    if args.verify and zone.rules:
+        errors = verify(zone, args.first, args.last, args.verify)
+        if errors:
+            sys.exit("%d changes differ from %s" % (errors, args.verify))
+        print("All changes agree with %s" % args.verify, file=sys.stderr)
+
+    if args.output:
+        with open(args.output, "w") as out:
+            write_header(out, args.tz, args.name, zone, args.first, args.last)
+    else:
+        write_header(sys.stdout, args.tz, args.name, zone, args.first, args.last)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,8 @@
+// Many logical timers on the single DS3231 Alarm 1, see Sodaq_AlarmScheduler.h
+
+#include "Sodaq_AlarmScheduler_impl.h"
+
+namespace sodaq_DS3231_nm {
+// The scheduler on Sodaq_DS3231, compiled once here; see the extern template
+template class AlarmSchedulerT<Sodaq_DS3231>;
+} //namespace sodaq_DS3231_nm
@@ -0,0 +1,82 @@
+// Many logical timers on the single DS3231 Alarm 1.
+//
+// Each timer has a period in seconds and a handler. The timers are kept in
+// a small binary heap ordered by deadline; only the nearest deadline is
+// programmed into Alarm 1, so the MCU wakes exactly once per distinct
+// deadline however many timers share it.
+//
+// Typical use: call dispatch() from loop() after the /INT interrupt fired
+// (not from the ISR itself, it talks to the RTC). dispatch() runs every due
+// handler, clears the alarm flag and programs the next deadline. Alarm 1
+// is only ever programmed from a time that was read successfully.
+//
+// AlarmScheduler runs on Sodaq_DS3231. For the driver on another bus,
+// include Sodaq_AlarmScheduler_impl.h and use AlarmSchedulerT:
+//
+//   Sodaq_DS3231T<TwoWireBus<Wire1> > rtc1;
+//   AlarmSchedulerT<Sodaq_DS3231T<TwoWireBus<Wire1> > > scheduler(rtc1);
+
+#ifndef SODAQ_ALARMSCHEDULER_H
+#define SODAQ_ALARMSCHEDULER_H
+
+#include "Sodaq_DS3231.h"
+
+#ifndef SODAQ_ALARM_SLOTS
+#define SODAQ_ALARM_SLOTS   8
+#endif
+#define SODAQ_ALARM_NONE    0xFF
+
+namespace sodaq_DS3231_nm {
+
+typedef void (*AlarmHandler_t)(uint8_t id);
+
+template <class Rtc>
+class AlarmSchedulerT {
+public:
+    explicit AlarmSchedulerT(Rtc &rtc);
+
+    // Add a timer firing every periodSecs, the first time at firstY2k
+    // (seconds since 2000), or one period from now if firstY2k is 0. A first
+    // deadline that isn't in the future is moved to one second from now.
+    // A period of 0 makes a one-shot timer. Returns the timer id, or
+    // SODAQ_ALARM_NONE if all SODAQ_ALARM_SLOTS are in use or the time
+    // can't be read.
+    uint8_t add(uint32_t periodSecs, AlarmHandler_t handler, uint32_t firstY2k = 0);
+    // Removing the nearest timer programs the next one, or turns Alarm 1
+    // off when none is left. If the time can't be read the old deadline
+    // stays programmed, and the RTC status is returned.
+    Ds3231Status_t remove(uint8_t id);
+
+    // Run every due handler, then clear the alarm flag and program the next
+    // deadline. Returns the number of handlers run. If the time can't be
+    // read nothing runs and the alarm flag is left set, so call it again.
+    uint8_t dispatch();
+
+    // Nearest deadline in seconds since 2000, 0 when no timer is active
+    uint32_t nextDeadline() const { return _count ? _timers[_heap[0]].deadline : 0; }
+    uint8_t count() const { return _count; }
+
+private:
+    struct Timer {
+        uint32_t deadline;
+        uint32_t period;
+        AlarmHandler_t handler;
+    };
+
+    void siftUp(uint8_t pos);
+    void siftDown(uint8_t pos);
+    void removeAt(uint8_t pos);
+    Ds3231Status_t program(uint32_t nowY2k);
+
+    Rtc &_rtc;
+    Timer _timers[SODAQ_ALARM_SLOTS];
+    uint8_t _heap[SODAQ_ALARM_SLOTS];   // Timer ids, min-heap on deadline
+    uint8_t _count;
+};
+
+typedef AlarmSchedulerT<Sodaq_DS3231> AlarmScheduler;
+// Instantiated in Sodaq_AlarmScheduler.cpp
+extern template class AlarmSchedulerT<Sodaq_DS3231>;
+
+} //namespace sodaq_DS3231_nm
+#endif
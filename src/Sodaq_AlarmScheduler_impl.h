@@ -0,0 +1,168 @@
+// AlarmSchedulerT member definitions, see Sodaq_AlarmScheduler.h.
+//
+// The library instantiates AlarmScheduler itself. Include this header
+// where the scheduler runs on a driver on another bus.
+
+#ifndef SODAQ_ALARMSCHEDULER_IMPL_H
+#define SODAQ_ALARMSCHEDULER_IMPL_H
+
+#include "Sodaq_AlarmScheduler.h"
+#include "Sodaq_DS3231_impl.h"
+
+namespace sodaq_DS3231_nm {
+
+// A MATCH_DATE alarm fires on the next date/hour/minute/second match, so a
+// deadline further away than the shortest month is reached in steps.
+#define ALARM_MAX_AHEAD     (27 * SECONDS_PER_DAY)
+
+template <class Rtc>
+AlarmSchedulerT<Rtc>::AlarmSchedulerT(Rtc &rtc) : _rtc(rtc), _count(0)
+{
+    for (uint8_t id = 0; id < SODAQ_ALARM_SLOTS; id++)
+        _timers[id].handler = 0;
+}
+
+template <class Rtc>
+uint8_t AlarmSchedulerT<Rtc>::add(uint32_t periodSecs, AlarmHandler_t handler, uint32_t firstY2k)
+{
+    if (!handler || _count >= SODAQ_ALARM_SLOTS)
+        return SODAQ_ALARM_NONE;
+    uint8_t id = 0;
+    while (_timers[id].handler)
+        id++;
+
+    // A failed read gives 2000-01-01, never phase a timer off that
+    uint32_t nowY2k = _rtc.now().get();
+    if (_rtc.lastStatus() != DS3231_OK)
+        return SODAQ_ALARM_NONE;
+    _timers[id].handler = handler;
+    _timers[id].period = periodSecs;
+    uint32_t deadline = firstY2k ? firstY2k : nowY2k + periodSecs;
+    // A passed deadline would only match again next month
+    _timers[id].deadline = deadline > nowY2k ? deadline : nowY2k + 1;
+    _heap[_count] = id;
+    siftUp(_count++);
+
+    if (_heap[0] == id)
+        program(nowY2k);
+    return id;
+}
+
+template <class Rtc>
+Ds3231Status_t AlarmSchedulerT<Rtc>::remove(uint8_t id)
+{
+    for (uint8_t pos = 0; pos < _count; pos++) {
+        if (_heap[pos] == id) {
+            removeAt(pos);
+            if (pos != 0)
+                return DS3231_OK;
+            if (!_count)
+                return program(0);
+            // Without the time the old deadline stays programmed; it fires
+            // early and dispatch() programs the next one then
+            uint32_t nowY2k = _rtc.now().get();
+            if (_rtc.lastStatus() != DS3231_OK)
+                return _rtc.lastStatus();
+            return program(nowY2k);
+        }
+    }
+    return DS3231_OK;
+}
+
+template <class Rtc>
+uint8_t AlarmSchedulerT<Rtc>::dispatch()
+{
+    uint8_t ran = 0;
+    uint32_t nowY2k = _rtc.now().get();
+    // Leave the alarm flag set when the time can't be read: the alarm that
+    // fired stays asserted for the next dispatch() rather than being
+    // reprogrammed from 2000-01-01
+    if (_rtc.lastStatus() != DS3231_OK)
+        return 0;
+    _rtc.clearINTStatus();
+    for (;;) {
+        while (_count && _timers[_heap[0]].deadline <= nowY2k) {
+            uint8_t id = _heap[0];
+            Timer &t = _timers[id];
+            AlarmHandler_t handler = t.handler;
+            if (t.period) {
+                // Skip any periods missed while asleep
+                t.deadline += ((nowY2k - t.deadline) / t.period + 1) * t.period;
+                siftDown(0);
+            } else {
+                removeAt(0);
+            }
+            handler(id);
+            ran++;
+        }
+        program(nowY2k);
+        // A deadline passed while the handlers ran or the alarm was written
+        // would otherwise only match again next month
+        if (!_count)
+            break;
+        nowY2k = _rtc.now().get();
+        if (_rtc.lastStatus() != DS3231_OK || _timers[_heap[0]].deadline > nowY2k)
+            break;
+    }
+    return ran;
+}
+
+template <class Rtc>
+Ds3231Status_t AlarmSchedulerT<Rtc>::program(uint32_t nowY2k)
+{
+    if (!_count)
+        return _rtc.disableAlarms();
+    uint32_t deadline = _timers[_heap[0]].deadline;
+    if (deadline > nowY2k + ALARM_MAX_AHEAD)
+        deadline = nowY2k + ALARM_MAX_AHEAD;
+    DateTime dt((long)deadline);
+    return _rtc.enableInterrupts(MATCH_DATE, dt.date(), dt.hour(), dt.minute(), dt.second());
+}
+
+template <class Rtc>
+void AlarmSchedulerT<Rtc>::removeAt(uint8_t pos)
+{
+    _timers[_heap[pos]].handler = 0;
+    _heap[pos] = _heap[--_count];
+    if (pos < _count) {
+        siftDown(pos);
+        siftUp(pos);
+    }
+}
+
+template <class Rtc>
+void AlarmSchedulerT<Rtc>::siftUp(uint8_t pos)
+{
+    while (pos) {
+        uint8_t parent = (pos - 1) / 2;
+        if (_timers[_heap[parent]].deadline <= _timers[_heap[pos]].deadline)
+            break;
+        uint8_t tmp = _heap[parent];
+        _heap[parent] = _heap[pos];
+        _heap[pos] = tmp;
+        pos = parent;
+    }
+}
+
+template <class Rtc>
+void AlarmSchedulerT<Rtc>::siftDown(uint8_t pos)
+{
+    for (;;) {
+        uint8_t least = pos;
+        uint8_t child = 2 * pos + 1;
+        if (child < _count && _timers[_heap[child]].deadline < _timers[_heap[least]].deadline)
+            least = child;
+        child++;
+        if (child < _count && _timers[_heap[child]].deadline < _timers[_heap[least]].deadline)
+            least = child;
+        if (least == pos)
+            break;
+        uint8_t tmp = _heap[least];
+        _heap[least] = _heap[pos];
+        _heap[pos] = tmp;
+        pos = least;
+    }
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
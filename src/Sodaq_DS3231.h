@@ -13,41 +13,238 @@
 
 #include <Arduino.h>
 #include <stdint.h>
+#include "Sodaq_I2cBus.h"
 
 
 
+#ifndef EPOCH_TIME_OFF
+#define EPOCH_TIME_OFF 946684800  // This is 2000-jan-01 00:00:00 in epoch time
+#endif
+#ifndef DS3231_ADDRESS
+#define DS3231_ADDRESS 0x68  // I2C slave address
+#endif
+#ifndef SECONDS_PER_DAY
+#define SECONDS_PER_DAY 86400L
+#endif
+
 namespace sodaq_DS3231_nm {
-// Simple general-purpose date/time class (no TZ / DST / leap second handling!)
+// Signed 64-bit seconds since the Unix epoch, for times past 2106
+typedef int64_t epoch64_t;
+
+// Text layouts for DateTime::format() and DateTime::printTo()
+enum DateTimeFormat_t {
+    DT_FMT_ISO8601,     // 2024-01-05 01:02:03, as addToString()
+    DT_FMT_ISO8601_T,   // 2024-01-05T01:02:03
+    DT_FMT_ISO8601_TZ,  // 2024-01-05T01:02:03Z
+    DT_FMT_COMPACT,     // 20240105010203
+    DT_FMT_CSV,         // 2024-01-05,01:02:03 (date and time columns)
+};
+// Longest formatted length, excluding the terminating NUL
+#define DT_FMT_MAX_LEN  20
+
+// A signed time interval, as RTClib's. Adding one to a DateTime steps its
+// fields; see DateTime::operator+=().
+class TimeSpan {
+public:
+    constexpr TimeSpan (int32_t seconds = 0) : _seconds(seconds) {}
+    constexpr TimeSpan (int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+        : _seconds(days * SECONDS_PER_DAY + hours * 3600L + minutes * 60L + seconds) {}
+
+    constexpr int16_t days() const        { return _seconds / SECONDS_PER_DAY; }
+    constexpr int8_t hours() const        { return _seconds / 3600 % 24; }
+    constexpr int8_t minutes() const      { return _seconds / 60 % 60; }
+    constexpr int8_t seconds() const      { return _seconds % 60; }
+    constexpr int32_t totalseconds() const { return _seconds; }
+
+    constexpr TimeSpan operator+(const TimeSpan &right) const { return TimeSpan(_seconds + right._seconds); }
+    constexpr TimeSpan operator-(const TimeSpan &right) const { return TimeSpan(_seconds - right._seconds); }
+
+protected:
+    int32_t _seconds;
+};
+
+// Marks DateTime's cached seconds as not yet known
+#define DT_SECS_UNKNOWN 0xFFFFFFFFUL
+// Larger steps of operator+=() convert through the seconds instead
+#define DT_STEP_MAX_DAYS    62
+
+// Simple general-purpose date/time class (no TZ / DST / leap second handling,
+// see Sodaq_LocalTime.h for local time)
+// DateTime is a literal type: with constant arguments every constructor
+// except the __FlashStringHelper one, and get()/getEpoch(), fold at compile time:
+//   constexpr DateTime built(__DATE__, __TIME__);
 class DateTime {
 public:
-    DateTime (long t =0); //Translates to years, and stores as offset from 2000.
-    DateTime (uint16_t year, uint8_t month, uint8_t date,
-              uint8_t hour, uint8_t min, uint8_t sec, uint8_t wday);
-    DateTime (const char* date, const char* time);
+    //Translates to years, and stores as offset from 2000.
+    constexpr DateTime (long t =0)
+        : DateTime(Step<0>(), (uint32_t)t, (uint16_t)((uint32_t)t / SECONDS_PER_DAY)) {}
+    constexpr DateTime (uint16_t year, uint8_t month, uint8_t date,
+              uint8_t hour, uint8_t min, uint8_t sec, uint8_t wd)
+        : yOff(year >= 2000 ? year - 2000 : year), m(month), d(date),
+          hh(hour), mm(min), ss(sec), wday(wd), secs(DT_SECS_UNKNOWN) {}
+    // A convenient constructor for using "the compiler's time":
+    //   DateTime now (__DATE__, __TIME__);
+    // sample input: date = "Dec 26 2009", time = "12:34:56"
+    constexpr DateTime (const char* date, const char* time)
+        : yOff(conv2d(date + 9)), m(conv2month(date)), d(conv2d(date + 4)),
+          hh(conv2d(time)), mm(conv2d(time + 3)), ss(conv2d(time + 6)),
+          wday(DayOfWeek(2000 + conv2d(date + 9), conv2month(date), conv2d(date + 4))),
+          secs(DT_SECS_UNKNOWN) {}
     DateTime (const __FlashStringHelper* date, const __FlashStringHelper* time);
 
-    uint8_t second() const      { return ss; }
-    uint8_t minute() const      { return mm; }
-    uint8_t hour() const        { return hh; }
+    constexpr uint8_t second() const      { return ss; }
+    constexpr uint8_t minute() const      { return mm; }
+    constexpr uint8_t hour() const        { return hh; }
 
-    uint8_t date() const        { return d; }
-    uint8_t month() const       { return m; }
-    uint16_t year() const       { return 2000 + yOff; }		// Notice the 2000 !
-    uint8_t year2k() const       { return yOff; }		// Notice the 2000 !
+    constexpr uint8_t date() const        { return d; }
+    constexpr uint8_t month() const       { return m; }
+    constexpr uint16_t year() const       { return 2000 + yOff; }		// Notice the 2000 !
+    constexpr uint8_t year2k() const       { return yOff; }		// Notice the 2000 !
 
-    uint8_t dayOfWeek() const   { return wday;}  /*Su=1 Mo=2 Tu=3 We=4 Th=5 Fr=6 Sa=7 */
+    constexpr uint8_t dayOfWeek() const   { return wday;}  /*Su=1 Mo=2 Tu=3 We=4 Th=5 Fr=6 Sa=7 */
 
-    // 32-bit time as seconds since 1/1/2000
-    uint32_t get() const;
+    // 32-bit time as seconds since 1/1/2000. It is kept from DateTime(long)
+    // and through operator+=(); otherwise a non-const DateTime works it out
+    // on the first call and keeps it, a const one each time.
+    constexpr uint32_t get() const {
+        return secs != DT_SECS_UNKNOWN ? secs : time2long(date2days(yOff, m, d), hh, mm, ss);
+    }
+    uint32_t get() {
+        if (secs == DT_SECS_UNKNOWN)
+            secs = time2long(date2days(yOff, m, d), hh, mm, ss);
+        return secs;
+    }
     // 32-bit number of seconds since Unix epoch (1970-01-01)
-    uint32_t getEpoch() const;
+    constexpr uint32_t getEpoch() const { return get() + EPOCH_TIME_OFF; }
+    uint32_t getEpoch() { return get() + EPOCH_TIME_OFF; }
     // 32-bit number of seconds since yr2000 UST/GMT (2000-01-01)
-    uint32_t getY2k_secs() const;
+    constexpr uint32_t getY2k_secs() const { return get(); }
+    // 64-bit seconds since yr2000 and since the Unix epoch, valid for every
+    // DateTime (2000..2255). 86400 = 675 * 128, so the day count is scaled
+    // with a 32-bit multiply and a shift.
+    constexpr int64_t getY2k64() const {
+        return ((int64_t)(days2k(yOff, m, d) * 675UL) << 7) + time2long(0, hh, mm, ss);
+    }
+    constexpr epoch64_t getEpoch64() const { return getY2k64() + EPOCH_TIME_OFF; }
+    // DateTime from 64-bit Unix time, with no 64-bit division. Times before
+    // 2000 give 2000-01-01 00:00:00, times after 2255 give 2255-12-31 23:59:59.
+    static DateTime fromEpoch64(epoch64_t t);
+
+    // Comparisons by the time, the day of the week is ignored
+    constexpr bool operator==(const DateTime &right) const { return get() == right.get(); }
+    constexpr bool operator!=(const DateTime &right) const { return get() != right.get(); }
+    constexpr bool operator<(const DateTime &right) const  { return get() < right.get(); }
+    constexpr bool operator>(const DateTime &right) const  { return get() > right.get(); }
+    constexpr bool operator<=(const DateTime &right) const { return get() <= right.get(); }
+    constexpr bool operator>=(const DateTime &right) const { return get() >= right.get(); }
+
+    // Step the fields by span, carrying into the month and year, with no
+    // conversion through the seconds for steps of up to DT_STEP_MAX_DAYS.
+    // Valid from 2000 until 2136, as get().
+    DateTime& operator+=(const TimeSpan &span);
+    DateTime& operator-=(const TimeSpan &span) { return *this += TimeSpan(-span.totalseconds()); }
+    DateTime operator+(const TimeSpan &span) const { DateTime dt(*this); return dt += span; }
+    DateTime operator-(const TimeSpan &span) const { DateTime dt(*this); return dt -= span; }
+    constexpr TimeSpan operator-(const DateTime &right) const { return TimeSpan((int32_t)(get() - right.get())); }
 
     void addToString(String & str) const;
+    // Heap free formatting. format() writes a NUL terminated string and
+    // returns its length, or 0 if it doesn't fit in size bytes.
+    size_t format(char *buf, size_t size, DateTimeFormat_t fmt = DT_FMT_ISO8601) const;
+    size_t printTo(Print &out, DateTimeFormat_t fmt = DT_FMT_ISO8601) const;
+
+    // number of days since 2000/01/01, valid for 2000..2179
+    static constexpr uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+        return days2k(y >= 2000 ? y - 2000 : y, m, d);
+    }
+    static constexpr uint32_t time2long(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
+        return ((days * 24UL + h) * 60 + m) * 60 + s;
+    }
+    // Two decimal digits, a leading space or non-digit counts as 0
+    static constexpr uint8_t conv2d(const char* p) {
+        return 10 * (('0' <= p[0] && p[0] <= '9') ? p[0] - '0' : 0) + p[1] - '0';
+    }
+    // Month number from the "Mmm" abbreviation used by __DATE__
+    static constexpr uint8_t conv2month(const char* p) {
+        return p[0] == 'J' ? (p[1] == 'a' ? 1 : p[2] == 'n' ? 6 : 7) :
+               p[0] == 'F' ? 2 :
+               p[0] == 'A' ? (p[2] == 'r' ? 4 : 8) :
+               p[0] == 'M' ? (p[2] == 'r' ? 3 : 5) :
+               p[0] == 'S' ? 9 :
+               p[0] == 'O' ? 10 :
+               p[0] == 'N' ? 11 : 12;
+    }
+    // Calculate the day of the week given the date
+    // https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week
+    // Implementation due to Tomohiko Sakamoto
+    // y > 1752, 1 <= m <= 12, returns 01 - 07, 01 = Sunday
+    static constexpr uint8_t DayOfWeek(int y, uint8_t m, uint8_t d) {
+        return sakamoto(y - (m < 3), m, d);
+    }
 
 protected:
     uint8_t yOff, m, d, hh, mm, ss, wday;
+    uint32_t secs;      // get(), or DT_SECS_UNKNOWN. Reset it when changing the fields.
+
+private:
+    // Converts arrays of times with the days-to-civil steps below
+    friend struct DateTimeBatch;
+
+    static uint8_t daysInMonth(uint8_t y, uint8_t m);
+    void stepDays(int16_t days);
+
+    // Days since 2000/01/01 for y = 0..255. 2100 and 2200 are not leap
+    // years; compared rather than divided, as 2400 is out of range.
+    static constexpr uint32_t days2k(uint16_t y, uint8_t m, uint8_t d) {
+        return d + (m > 2 ? (153 * (m - 3) + 2) / 5 + 59 : (m - 1) * 31)
+                 + (m > 2 && y % 4 == 0 && y != 100 && y != 200)
+                 + 365UL * y + (y + 3) / 4 - (y > 100) - (y > 200) - 1;
+    }
+    static constexpr uint8_t sakamoto(int y, uint8_t m, uint8_t d) {
+        return ((y + y/4 - y/100 + y/400 + "\0\3\2\5\0\3\5\1\4\6\2\4"[m-1] + d) % 7) + 1;
+    }
+
+    // Days-to-civil conversion, after Howard Hinnant's civil_from_days():
+    // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    // Days are counted from 2000-03-01, which starts a 400 year era, so the leap
+    // day falls at the end of each "year of era" and no month table is needed.
+    // Valid for every date a uint32_t of y2k seconds can reach (until 2136),
+    // which keeps all intermediate values within 16 bits. fromEpoch64() first
+    // removes whole centuries, all 36524 days long from 2000-03-01 to 2300.
+    // T is uint16_t here; DateTimeBatch uses uint32_t, which vectorises.
+    template <class T> static constexpr T civilYoe(T doe) {
+        return (doe - doe / 1460 + doe / 36524) / 365;   // year of era [0, 136]
+    }
+    template <class T> static constexpr T civilDoy(T doe, T yoe) {
+        return doe - (365 * yoe + yoe / 4 - yoe / 100);  // day of year from Mar 1 [0, 365]
+    }
+    template <class T> static constexpr T civilMp(T doy) {
+        return (5 * doy + 2) / 153;                      // month from March [0, 11]
+    }
+
+    // A C++11 constexpr constructor can't hold statements, so DateTime(long)
+    // hands each intermediate on to the next step and computes it only once.
+    template <uint8_t N> struct Step {};
+    constexpr DateTime (Step<0>, uint32_t t, uint16_t days)
+        : DateTime(Step<1>(), t, days, (uint32_t)(t - days * SECONDS_PER_DAY)) {}
+    constexpr DateTime (Step<1>, uint32_t t, uint16_t days, uint32_t sod)
+        : DateTime(Step<2>(), t, days, (uint8_t)(sod / 3600), sod) {}
+    constexpr DateTime (Step<2>, uint32_t t, uint16_t days, uint8_t hour, uint32_t sod)
+        : DateTime(Step<3>(), t, days, hour, (uint16_t)(sod - hour * 3600UL),
+                   (uint16_t)(days < 31 + 29 ? 0 : days - (31 + 29))) {}
+    constexpr DateTime (Step<3>, uint32_t t, uint16_t days, uint8_t hour, uint16_t soh, uint16_t doe)
+        : DateTime(Step<4>(), t, days, hour, soh, doe, civilYoe(doe)) {}
+    constexpr DateTime (Step<4>, uint32_t t, uint16_t days, uint8_t hour, uint16_t soh, uint16_t doe, uint16_t yoe)
+        : DateTime(Step<5>(), t, days, hour, soh, yoe, civilDoy(doe, yoe)) {}
+    constexpr DateTime (Step<5>, uint32_t t, uint16_t days, uint8_t hour, uint16_t soh, uint16_t yoe, uint16_t doy)
+        : DateTime(Step<6>(), t, days, hour, soh, yoe, doy, civilMp(doy)) {}
+    // Jan/Feb 2000 precede the 2000-03-01 base and are special cased.
+    // 2000-01-01 was a Saturday, 01 = Sunday.
+    constexpr DateTime (Step<6>, uint32_t t, uint16_t days, uint8_t hour, uint16_t soh, uint16_t yoe, uint16_t doy, uint8_t mp)
+        : yOff(days < 31 + 29 ? 0 : yoe + (mp >= 10)),
+          m(days < 31 + 29 ? (days < 31 ? 1 : 2) : (mp < 10 ? mp + 3 : mp - 9)),
+          d(days < 31 + 29 ? (days < 31 ? days + 1 : days - 30) : doy - (153 * mp + 2) / 5 + 1),
+          hh(hour), mm(soh / 60), ss(soh % 60), wday((days + 6) % 7 + 1), secs(t) {}
 };
 
 // These are the constants for periodicity of enableInterrupts() below.
@@ -55,6 +252,80 @@ protected:
 #define EveryMinute     0x02
 #define EveryHour       0x03
 
+// Result of a device operation, see lastStatus()
+enum Ds3231Status_t {
+    DS3231_OK = 0,
+    DS3231_NACK,        // The DS3231 didn't acknowledge its address or a byte
+    DS3231_SHORT_READ,  // requestFrom() returned fewer bytes than asked
+    DS3231_BUS_ERROR,   // Any other TwoWire error, e.g. its own timeout
+    DS3231_TIMEOUT,     // The time budget of the call ran out
+    DS3231_BAD_DATA,    // The time registers don't hold a valid BCD time
+};
+
+// Retries of a failed transfer, and the time budget of a public call in ms.
+// The budget covers the waits of syncClock() (1.1 s) and
+// convertTemperature() (250 ms); see setBusTimeout().
+#ifndef SODAQ_DS3231_RETRIES
+#define SODAQ_DS3231_RETRIES    2
+#endif
+#ifndef SODAQ_DS3231_BUDGET_MS
+#define SODAQ_DS3231_BUDGET_MS  1500
+#endif
+
+// The public calls. Bus statistics and the time budget belong to the
+// outermost one, e.g. setEpoch() when it calls setDateTime().
+enum Sodaq_DS3231_Api_t {
+    DS3231_API_OTHER,               // Traffic outside the calls below
+    DS3231_API_BEGIN,
+    DS3231_API_SET_DATE_TIME,       // setDateTime(), setEpoch()
+    DS3231_API_NOW,                 // now(), readNow(), snapshotNow()
+    DS3231_API_SYNC_CLOCK,          // syncClock(), getEpochMs()
+    DS3231_API_ENABLE_INTERRUPTS,   // All enableInterrupts*() variants
+    DS3231_API_DISABLE_INTERRUPTS,
+    DS3231_API_CLEAR_INT_STATUS,
+    DS3231_API_SQUARE_WAVE,         // setSquareWave(), enable32kHz()
+    DS3231_API_CONVERT_TEMPERATURE, // convertTemperature(), startTemperatureConversion(), pollTemperature()
+    DS3231_API_GET_TEMPERATURE,     // getTemperature(), getTemperatureQuarters()
+    DS3231_API_AGING_OFFSET,        // getAgingOffset(), setAgingOffset()
+    DS3231_API_REFRESH_REGISTERS,
+    DS3231_API_COMMIT_BATCH,
+    DS3231_API_COUNT
+};
+
+#if defined SODAQ_DS3231_BUS_STATS
+// Transaction durations are binned by log2 of micros(): bin 0 is 0-1 us,
+// bin n is 2^n to 2^(n+1)-1 us, the last bin takes everything longer.
+#ifndef SODAQ_BUS_HIST_BINS
+#define SODAQ_BUS_HIST_BINS 16
+#endif
+
+// A transaction is one register read (address write, then requestFrom)
+// or one register burst write.
+struct Sodaq_DS3231_ApiStats {
+    uint32_t transactions;
+    uint32_t bytes;         // bytes written and read, incl. register pointer
+    uint32_t nacks;         // endTransmission() reported an error
+    uint32_t shortReads;    // requestFrom() returned fewer bytes than asked
+};
+
+// I2C traffic generated by the driver since the last resetBusStats().
+// A register read costs two starts (address write, then requestFrom),
+// a register write costs one.
+struct Sodaq_DS3231_BusStats {
+    uint32_t starts;        // START and repeated START conditions
+    uint32_t stops;         // STOP conditions
+    uint32_t requests;      // requestFrom() calls
+    uint32_t bytesWritten;  // bytes sent after the slave address, incl. register pointer
+    uint32_t bytesRead;     // bytes received
+    uint32_t nacks;
+    uint32_t shortReads;
+    uint32_t retries;       // Transfers repeated after a failure
+    uint32_t recoveries;    // Bus::recover() calls
+    uint32_t durationHist[SODAQ_BUS_HIST_BINS];     // Transactions per log2(us) bin
+    Sodaq_DS3231_ApiStats api[DS3231_API_COUNT];    // Indexed by Sodaq_DS3231_Api_t
+};
+#endif
+
 //Alarm masks
 enum ALARM_TYPES_t {
     EVERY_SECOND = 0x0F,
@@ -65,44 +336,224 @@ enum ALARM_TYPES_t {
     MATCH_DAY = 0x10,         //match day *and* hours, minutes, seconds
 };
 
-// RTC DS3231 chip connected via I2C and uses the Wire library.
+// Square-wave output rates, see setSquareWave()
+enum SqwRate_t {
+    SQW_OFF,
+    SQW_1HZ,
+    SQW_1KHZ,       // DS3231 1.024 kHz, PCF8523 1.024 kHz
+    SQW_4KHZ,       // 4.096 kHz
+    SQW_8KHZ,       // 8.192 kHz
+    SQW_32KHZ,      // DS3231 on its separate 32kHz pin
+};
+
+// Called with the new temperature in 1/4 deg C when a conversion completes
+typedef void (*TemperatureCallback_t)(int16_t quarterDegC);
+
+// Number of DS3231 registers, 0x00 (seconds) to 0x12 (temperature LSB)
+#define DS3231_REG_COUNT    0x13
+
+// RTC DS3231 chip connected via I2C.
 // Only 24 Hour time format is supported in this implementation
-class Sodaq_DS3231 {
+// Bus is the I2C transport (see Sodaq_I2cBus.h), fixed at compile time.
+// Sodaq_DS3231 is the driver on Wire; for another bus include
+// Sodaq_DS3231_impl.h, e.g. Sodaq_DS3231T<TwoWireBus<Wire1> > rtc;
+template <class Bus, uint8_t Address = DS3231_ADDRESS>
+class Sodaq_DS3231T {
 public:
-    uint8_t begin(void);
+    Sodaq_DS3231T();
+    uint8_t begin(void);        // 1 on success
 
-    void setDateTime(const DateTime& dt);  //Changes the date-time
-    void setEpoch(uint32_t ts); // Set the RTC using timestamp (seconds since epoch)
-    DateTime now();            //Gets the current date-time
+    // Every call that talks to the device records a Ds3231Status_t, which
+    // lastStatus() returns; calls without a value return it directly. A
+    // failed transfer is retried up to retries times, after Bus::recover()
+    // if the bus itself failed. Once a transfer has failed for good, the
+    // rest of the call sends nothing. No transfer starts after budgetMs
+    // from the start of the call, so a call takes at most budgetMs plus one
+    // transfer, with the TwoWire timeout bounding a transfer.
+    Ds3231Status_t lastStatus() const { return _status; }
+    void setBusTimeout(uint8_t retries, uint16_t budgetMs);
+
+    Ds3231Status_t setDateTime(const DateTime& dt);  //Changes the date-time
+    Ds3231Status_t setEpoch(uint32_t ts); // Set the RTC using timestamp (seconds since epoch)
+    DateTime now();            //Gets the current date-time, 2000-01-01 00:00:00 if the read fails
+    DateTime readNow();        //Gets the current date-time from the RTC, bypassing the clock cache
+    // As above, dt is only changed on success
+    Ds3231Status_t now(DateTime &dt);
+    Ds3231Status_t readNow(DateTime &dt);
 
     DateTime makeDateTime(unsigned long t);
 
     //Decides the /INT pin's output setting
     //periodicity can be any of following defines: EverySecond, EveryMinute, EveryHour
-    void enableInterrupts(uint8_t periodicity);
-    void enableInterrupts(uint8_t hh24, uint8_t mm,uint8_t ss);
-    void enableInterrupts(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24, uint8_t mm, uint8_t ss);
-    void disableInterrupts();
-    void clearINTStatus();
-
-    void convertTemperature(bool waitToFinish=true);
-    float getTemperature();
+    Ds3231Status_t enableInterrupts(uint8_t periodicity);
+    Ds3231Status_t enableInterrupts(uint8_t hh24, uint8_t mm,uint8_t ss);
+    Ds3231Status_t enableInterrupts(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24, uint8_t mm, uint8_t ss);
+    Ds3231Status_t disableInterrupts();
+    // Only clear the alarm interrupt enables, without the delays of begin()
+    Ds3231Status_t disableAlarms();
+    Ds3231Status_t clearINTStatus();
+
+    // Square wave on the INT/SQW pin, which then no longer signals alarms;
+    // begin(), disableInterrupts() and enableInterrupts() turn it off. The
+    // seconds register advances on the falling edge of the 1 Hz output.
+    // SQW_32KHZ turns the SQW pin off and the 32kHz pin on.
+    Ds3231Status_t setSquareWave(SqwRate_t rate);
+    // The 32kHz pin on its own, alongside SQW or alarms
+    Ds3231Status_t enable32kHz(bool enable = true);
+
+    Ds3231Status_t convertTemperature(bool waitToFinish=true);
+    float getTemperature();    // 0 if the read fails
+
+    // Aging offset register, about 0.1 ppm per LSB at 25 deg C. Positive
+    // values slow the oscillator. A new value takes effect at the next
+    // temperature conversion, which setAgingOffset() starts.
+    int8_t getAgingOffset();
+    Ds3231Status_t setAgingOffset(int8_t offset);
+
+    // Non-blocking temperature conversion: start it, then call
+    // pollTemperature() from the loop until it returns true (about 125 ms
+    // later). Each poll is one single-byte read; on completion the new value
+    // is fetched and passed to the onTemperatureReady() callback.
+    bool startTemperatureConversion();
+    bool pollTemperature();
+    void onTemperatureReady(TemperatureCallback_t callback);
+    int16_t getTemperatureQuarters();   // 1/4 deg C, e.g. 101 = 25.25 deg C
+
+    // Shadow register cache. When enabled, register reads (control, status,
+    // alarms, aging offset, temperature) are served from a copy of the whole
+    // register map filled by one burst read, and register writes go to both
+    // the device and the copy.
+    // The device changes the time, the status flags, the CONV bit and the
+    // temperature on its own, so the copy is a snapshot: call
+    // refreshRegisters() once per wake cycle, or invalidateRegisters() to
+    // make the next read refresh it. The cached temperature follows those
+    // refreshes only, not the device's own conversions every 64 s. After
+    // startTemperatureConversion() it is read from the bus until
+    // pollTemperature() sees the conversion finish and updates the copy.
+    void enableRegisterCache(bool enable = true);
+    bool refreshRegisters();        // One 19-byte burst read, true if complete
+    void invalidateRegisters() { _cacheValid = false; }
+    DateTime snapshotNow();         // Date-time captured by the last refresh
+
+    // Cached clock. Once anchored to the start of an RTC second, now() and
+    // getEpochMs() are extrapolated from millis() with no bus traffic.
+    // The anchor is renewed after resyncMs from a fresh clockEdge(). Without
+    // one, a single read of the time corrects the seconds and the next fresh
+    // edge restores the millisecond phase; syncClock() instead polls for the
+    // seconds rollover (blocks up to 1 s) and phases it at once.
+    // Each edge resync measures the extrapolation error; above maxDriftMs the
+    // interval is halved (down to 1 s), well below it grows back to resyncMs.
+    // clockEdge() is ISR safe; between resyncs every edge re-phases the
+    // milliseconds without a bus read.
+    void enableClockCache(uint32_t resyncMs = 600000UL, uint16_t maxDriftMs = 20);
+    void disableClockCache();
+    void clockEdge();
+    bool syncClock();
+    uint32_t getEpochMs(uint16_t &ms);
+    int32_t getClockDrift() const { return _clockDriftMs; } // ms, at the last resync
+    uint32_t getClockResyncInterval() const { return _resyncMs; }
+
+    // Write batching. Between beginRegisterBatch() and commitRegisterBatch()
+    // register writes are only staged; the commit merges them into the
+    // fewest auto-incrementing bursts. With a valid register cache, small
+    // gaps in the alarm registers are bridged by rewriting their cached
+    // values. Batches nest; the outermost commit sends. Register reads in a
+    // batch return the staged values, and never refresh the cache.
+    void beginRegisterBatch();
+    uint8_t commitRegisterBatch();
+
+#if defined SODAQ_DS3231_BUS_STATS
+    // Bus counters, NACKs, short reads and the duration histogram, in total
+    // and per public call. They take about 330 bytes of RAM.
+    const Sodaq_DS3231_BusStats& getBusStats() const { return _busStats; }
+    void resetBusStats();
+#endif
 private:
+    // Marks a public call. The outermost one clears the status and starts
+    // the time budget.
+    class CallScope {
+    public:
+        CallScope(Sodaq_DS3231T &rtc, uint8_t api) : _rtc(rtc) {
+            if (_rtc._callDepth++ == 0) {
+                _rtc._status = DS3231_OK;
+                _rtc._callStartMs = millis();
+#if defined SODAQ_DS3231_BUS_STATS
+                _rtc._busApi = api;
+#endif
+            }
+            (void)api;
+        }
+        ~CallScope() {
+            if (--_rtc._callDepth == 0) {
+#if defined SODAQ_DS3231_BUS_STATS
+                _rtc._busApi = DS3231_API_OTHER;
+#endif
+            }
+        }
+    private:
+        Sodaq_DS3231T &_rtc;
+    };
+
     uint8_t readRegister(uint8_t regaddress);
+    void cacheRegisters(uint8_t regaddress, const uint8_t *buf, uint8_t len);
     void writeRegister(uint8_t regaddress, uint8_t value);
+    Ds3231Status_t readRegisters(uint8_t regaddress, uint8_t *buf, uint8_t len);
+    Ds3231Status_t writeRegisters(uint8_t regaddress, const uint8_t *buf, uint8_t len);
     void writeRegister_pm(uint8_t regaddress, uint8_t *buf, uint8_t len);
+    Ds3231Status_t readOnce(uint8_t regaddress, uint8_t *buf, uint8_t len);
+    Ds3231Status_t writeOnce(uint8_t regaddress, const uint8_t *buf, uint8_t len);
+    Ds3231Status_t beginAttempt(uint8_t attempt, Ds3231Status_t lastError);
+
+    Ds3231Status_t _status;     // Of the current or last public call
+    uint8_t _callDepth;
+    uint32_t _callStartMs;
+    uint8_t _retries;
+    uint16_t _budgetMs;
+
+    uint8_t _regs[DS3231_REG_COUNT];
+    bool _cacheEnabled;
+    bool _cacheValid;
+    uint8_t _batchDepth;
+    uint32_t _batchDirty;   // Bit n set when register n is staged
+
+    void anchorClock(uint32_t edgeMs);
+    void checkClock(uint32_t nowMs);
+    uint32_t cachedY2k(uint16_t &ms);
+    bool _clockCache;
+    bool _clockAnchored;
+    bool _clockPhased;      // _anchorMs is a measured start of second
+    volatile bool _edgePending;
+    volatile uint32_t _edgeMs;
+    uint32_t _anchorY2k;    // RTC time at _anchorMs, seconds since 2000
+    uint32_t _anchorMs;     // millis() at the start of second _anchorY2k
+    uint32_t _resyncMs;
+    uint32_t _resyncMaxMs;
+    uint16_t _maxDriftMs;
+    int32_t _clockDriftMs;
+
+    int16_t readTemperatureQuarters();
+    static int16_t temperatureQuarters(const uint8_t *buf);
+    bool _tempConverting;
+    TemperatureCallback_t _tempCallback;
 
 public:
     uint8_t enableInterruptsCheckAlm1(uint8_t periodicity);
     //Alm2 in testing didn't create an interrupt. Alm1 created interrupts
     uint8_t enableInterruptsCheckAlm2(uint8_t periodicity);
     void    enableInterruptsAlm2(uint8_t periodicity);
+
+#if defined SODAQ_DS3231_BUS_STATS
+private:
+    void recordTransaction(uint32_t startUs, uint8_t bytes, bool nack, bool shortRead);
+    Sodaq_DS3231_BusStats _busStats;
+    uint8_t _busApi;        // Sodaq_DS3231_Api_t of the outermost call
+#endif
 };
-//expect to have MS_SAMD_DS3231 defined to enable
-extern Sodaq_DS3231 rtcExtPhy;
-} //namespace sodaq_DS3231_nm
 
-#if defined ADAFRUIT_FEATHERWING_RTC_SD
+typedef Sodaq_DS3231T<WireBus> Sodaq_DS3231;
+// Instantiated in Sodaq_DS3231.cpp
+extern template class Sodaq_DS3231T<WireBus>;
+
 // RTC based on the PCF8523 chip connected via I2C and the Wire library
 #define PCF8523_ADDRESS       0x68
 #define PCF8523_CLKOUTCONTROL 0x0F
@@ -121,6 +572,18 @@ public:
     Pcf8523SqwPinMode readSqwPinMode();
     void writeSqwPinMode(Pcf8523SqwPinMode mode);
 };
+
+// The board's RTC instance. Both drivers are always built; the define
+// only selects which one rtcExtPhy is.
+#if defined ADAFRUIT_FEATHERWING_RTC_SD
 extern RTC_PCF8523 rtcExtPhy;
-#endif //ADAFRUIT_FEATHERWING_RTC_SD
+#else
+extern Sodaq_DS3231 rtcExtPhy;
+#endif
+} //namespace sodaq_DS3231_nm
+
+#if defined ADAFRUIT_FEATHERWING_RTC_SD
+// RTC_PCF8523 used to be declared outside the namespace
+using sodaq_DS3231_nm::RTC_PCF8523;
+#endif
 #endif
@@ -0,0 +1,1061 @@
+// Sodaq_DS3231T member definitions.
+//
+// The library instantiates Sodaq_DS3231T<WireBus> (Sodaq_DS3231) itself.
+// Include this header where the driver is used on any other bus:
+//
+//   #include <Sodaq_DS3231_impl.h>
+//   Sodaq_DS3231T<TwoWireBus<Wire1> > rtc;
+
+#ifndef SODAQ_DS3231_IMPL_H
+#define SODAQ_DS3231_IMPL_H
+
+#include <avr/pgmspace.h>
+#include "Sodaq_DS3231.h"
+#include "Sodaq_RtcBackend.h"
+
+namespace sodaq_DS3231_nm {
+
+/* DS3231 Registers. Refer Sec 8.2 of application manual */
+#define DS3231_SEC_REG        0x00
+#define DS3231_MIN_REG        0x01
+#define DS3231_HOUR_REG       0x02
+#define DS3231_WDAY_REG       0x03
+#define DS3231_MDAY_REG       0x04
+#define DS3231_MONTH_REG      0x05
+#define DS3231_YEAR_REG       0x06
+
+#define DS3231_AL1SEC_REG     0x07
+#define DS3231_AL1MIN_REG     0x08
+#define DS3231_AL1HOUR_REG    0x09
+#define DS3231_AL1WDAY_REG    0x0A
+
+#define DS3231_AL2MIN_REG     0x0B
+#define DS3231_AL2HOUR_REG    0x0C
+#define DS3231_AL2WDAY_REG    0x0D
+
+#define DS3231_CONTROL_REG          0x0E
+#define DS3231_STATUS_REG           0x0F
+#define DS3231_AGING_OFFSET_REG     0x10
+#define DS3231_TMP_UP_REG           0x11
+#define DS3231_TMP_LOW_REG          0x12
+
+////////////////////////////////////////////////////////////////////////////////
+// RTC DS3231 implementation
+
+#if defined SODAQ_DS3231_BUS_STATS
+#define SODAQ_BUS_COUNT(field, n)   _busStats.field += (n)
+#define SODAQ_BUS_START()           uint32_t busStartUs = micros()
+#define SODAQ_BUS_DONE(bytes, nack, shortRead)  recordTransaction(busStartUs, bytes, nack, shortRead)
+#else
+#define SODAQ_BUS_COUNT(field, n)
+#define SODAQ_BUS_START()
+#define SODAQ_BUS_DONE(bytes, nack, shortRead)
+#endif
+// At the top of every public call that talks to the device
+#define SODAQ_DS3231_CALL(api)      CallScope callScope(*this, api)
+
+// A TwoWire endTransmission() result: 2 and 3 are a NACK on the address or
+// on a data byte, 1, 4 and 5 (timeout, on cores that have one) are errors
+inline Ds3231Status_t wireStatus(uint8_t err)
+{
+    return err == 0 ? DS3231_OK : (err == 2 || err == 3) ? DS3231_NACK : DS3231_BUS_ERROR;
+}
+
+// Whether attempt n (0 first) of a transfer may go ahead: DS3231_OK, or the
+// error to give up with. A retry after a bus error recovers the bus first.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::beginAttempt(uint8_t attempt, Ds3231Status_t lastError)
+{
+    if (attempt == 0 && _status != DS3231_OK)
+        return _status;     // An earlier transfer of this call failed
+    if (attempt > _retries)
+        return lastError;
+    if (millis() - _callStartMs >= _budgetMs)
+        return DS3231_TIMEOUT;
+    if (attempt > 0) {
+        SODAQ_BUS_COUNT(retries, 1);
+        if (lastError == DS3231_BUS_ERROR) {
+            Bus::recover();
+            SODAQ_BUS_COUNT(recoveries, 1);
+        }
+    }
+    return DS3231_OK;
+}
+
+// Read len consecutive registers starting at regaddress in one
+// write+restart+read transaction, retrying as set by setBusTimeout().
+// On failure buf is zeroed.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::readRegisters(uint8_t regaddress, uint8_t *buf, uint8_t len)
+{
+    Ds3231Status_t status = DS3231_OK;
+    for (uint8_t attempt = 0; ; attempt++) {
+        status = beginAttempt(attempt, status);
+        if (status != DS3231_OK)
+            break;
+        status = readOnce(regaddress, buf, len);
+        if (status == DS3231_OK)
+            return DS3231_OK;
+    }
+    memset(buf, 0, len);
+    _status = status;
+    return status;
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::readOnce(uint8_t regaddress, uint8_t *buf, uint8_t len)
+{
+    SODAQ_BUS_START();
+    Bus::beginTransmission(Address);
+    Bus::write(regaddress);
+    uint8_t err = Bus::endTransmission();
+    SODAQ_BUS_COUNT(starts, 1);
+    SODAQ_BUS_COUNT(bytesWritten, 1);
+    SODAQ_BUS_COUNT(stops, 1);
+
+    uint8_t sz_read = 0;
+    if (err == 0) {
+        sz_read = Bus::requestFrom(Address, len);
+        SODAQ_BUS_COUNT(requests, 1);
+        SODAQ_BUS_COUNT(starts, 1);
+        SODAQ_BUS_COUNT(stops, 1);
+        for (uint8_t lp = 0; lp < sz_read && lp < len; lp++) {
+            buf[lp] = Bus::read();
+        }
+        SODAQ_BUS_COUNT(bytesRead, sz_read);
+    }
+    SODAQ_BUS_DONE(1 + sz_read, err != 0, err == 0 && sz_read < len);
+    if (err != 0)
+        return wireStatus(err);
+    return sz_read < len ? DS3231_SHORT_READ : DS3231_OK;
+}
+
+// Write len consecutive registers starting at regaddress in one
+// auto-incrementing burst, retrying as set by setBusTimeout().
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::writeRegisters(uint8_t regaddress, const uint8_t *buf, uint8_t len)
+{
+    if (_batchDepth && regaddress + len <= DS3231_REG_COUNT) {
+        // Stage in the register copy, commitRegisterBatch() sends it
+        for (uint8_t lp = 0; lp < len; lp++) {
+            _regs[regaddress + lp] = buf[lp];
+            _batchDirty |= 1UL << (regaddress + lp);
+        }
+        return DS3231_OK;
+    }
+
+    Ds3231Status_t status = DS3231_OK;
+    for (uint8_t attempt = 0; ; attempt++) {
+        status = beginAttempt(attempt, status);
+        if (status != DS3231_OK)
+            break;
+        status = writeOnce(regaddress, buf, len);
+        if (status == DS3231_OK) {
+            if (_cacheEnabled && regaddress + len <= DS3231_REG_COUNT && buf != &_regs[regaddress])
+                memcpy(&_regs[regaddress], buf, len);
+            return DS3231_OK;
+        }
+    }
+    // What the device holds now is unknown
+    _cacheValid = false;
+    _status = status;
+    return status;
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::writeOnce(uint8_t regaddress, const uint8_t *buf, uint8_t len)
+{
+    SODAQ_BUS_START();
+    Bus::beginTransmission(Address);
+    Bus::write(regaddress);
+    for (uint8_t lp = 0; lp < len; lp++) {
+        Bus::write(buf[lp]);
+    }
+    uint8_t err = Bus::endTransmission();
+    SODAQ_BUS_COUNT(starts, 1);
+    SODAQ_BUS_COUNT(bytesWritten, 1 + len);
+    SODAQ_BUS_COUNT(stops, 1);
+    SODAQ_BUS_DONE(1 + len, err != 0, false);
+    return wireStatus(err);
+}
+
+// Registers that only change when written, so a valid cached copy may be
+// rewritten to bridge two dirty runs: the alarms (0x07-0x0D) and aging offset.
+#define DS3231_STABLE_REGS  ((0x7FUL << DS3231_AL1SEC_REG) | (1UL << DS3231_AGING_OFFSET_REG))
+// Rewriting a register costs one byte, a new burst costs a start, the slave
+// address, the register pointer and a stop.
+#define DS3231_BATCH_GAP_MAX    3
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::beginRegisterBatch()
+{
+    _batchDepth++;
+}
+
+// Send the registers staged since beginRegisterBatch() in ascending order,
+// as the fewest auto-incrementing bursts. Returns the number of bursts.
+template <class Bus, uint8_t Address>
+uint8_t Sodaq_DS3231T<Bus, Address>::commitRegisterBatch()
+{
+    SODAQ_DS3231_CALL(DS3231_API_COMMIT_BATCH);
+    if (_batchDepth == 0 || --_batchDepth)
+        return 0;
+
+    uint32_t dirty = _batchDirty;
+    _batchDirty = 0;
+    bool gapsKnown = _cacheEnabled && _cacheValid;
+    uint8_t bursts = 0;
+    uint8_t reg = 0;
+    while (reg < DS3231_REG_COUNT) {
+        if (!(dirty & (1UL << reg))) {
+            reg++;
+            continue;
+        }
+        uint8_t end = reg;
+        for (;;) {
+            while (end < DS3231_REG_COUNT && (dirty & (1UL << end)))
+                end++;
+            uint8_t next = end;
+            while (next < DS3231_REG_COUNT && !(dirty & (1UL << next)))
+                next++;
+            uint32_t gap = ((1UL << next) - 1) & ~((1UL << end) - 1);
+            if (!gapsKnown || next >= DS3231_REG_COUNT
+                    || next - end > DS3231_BATCH_GAP_MAX
+                    || (gap & ~DS3231_STABLE_REGS))
+                break;
+            end = next;     // Bridge with the cached values already in _regs
+        }
+        writeRegisters(reg, &_regs[reg], end - reg);
+        bursts++;
+        reg = end;
+    }
+    if (!gapsKnown)
+        _cacheValid = false;    // _regs now holds a partial copy
+    return bursts;
+}
+
+// Inside a batch a staged register reads back its staged value, and a
+// missing cache is not refreshed: the one byte is read from the device.
+template <class Bus, uint8_t Address>
+uint8_t Sodaq_DS3231T<Bus, Address>::readRegister(uint8_t regaddress)
+{
+    if (regaddress < DS3231_REG_COUNT) {
+        if (_batchDirty & (1UL << regaddress))
+            return _regs[regaddress];
+        if (_cacheEnabled && (_cacheValid || (!_batchDepth && refreshRegisters())))
+            return _regs[regaddress];
+    }
+    uint8_t value;
+    readRegisters(regaddress, &value, 1);
+    return value;
+}
+
+// Copy registers read from the device into the register copy, keeping the
+// ones an open batch has staged there
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::cacheRegisters(uint8_t regaddress, const uint8_t *buf, uint8_t len)
+{
+    for (uint8_t lp = 0; lp < len; lp++) {
+        if (!(_batchDirty & (1UL << (regaddress + lp))))
+            _regs[regaddress + lp] = buf[lp];
+    }
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::writeRegister(uint8_t regaddress,uint8_t value)
+{
+    writeRegisters(regaddress, &value, 1);
+}
+
+template <class Bus, uint8_t Address>
+Sodaq_DS3231T<Bus, Address>::Sodaq_DS3231T() :
+    _status(DS3231_OK), _callDepth(0), _callStartMs(0),
+    _retries(SODAQ_DS3231_RETRIES), _budgetMs(SODAQ_DS3231_BUDGET_MS),
+    _cacheEnabled(false), _cacheValid(false),
+    _batchDepth(0), _batchDirty(0),
+    _clockCache(false), _clockAnchored(false), _clockPhased(false), _edgePending(false),
+    _clockDriftMs(0),
+    _tempConverting(false), _tempCallback(0)
+{
+#if defined SODAQ_DS3231_BUS_STATS
+    resetBusStats();
+#endif
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::setBusTimeout(uint8_t retries, uint16_t budgetMs)
+{
+    _retries = retries;
+    _budgetMs = budgetMs;
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::enableRegisterCache(bool enable)
+{
+    _cacheEnabled = enable;
+    _cacheValid = false;
+}
+
+template <class Bus, uint8_t Address>
+bool Sodaq_DS3231T<Bus, Address>::refreshRegisters()
+{
+    SODAQ_DS3231_CALL(DS3231_API_REFRESH_REGISTERS);
+    uint8_t buf[DS3231_REG_COUNT];
+    _cacheValid = (readRegisters(DS3231_SEC_REG, buf, DS3231_REG_COUNT) == DS3231_OK);
+    if (_cacheValid)
+        cacheRegisters(DS3231_SEC_REG, buf, DS3231_REG_COUNT);
+    return _cacheValid;
+}
+
+template <class Bus, uint8_t Address>
+DateTime Sodaq_DS3231T<Bus, Address>::snapshotNow()
+{
+    SODAQ_DS3231_CALL(DS3231_API_NOW);
+    if (!_cacheValid && !refreshRegisters())
+        return DateTime();
+    return RtcCodec<Ds3231Chip>::decode(&_regs[DS3231_SEC_REG]);
+}
+
+#if defined SODAQ_DS3231_BUS_STATS
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::resetBusStats()
+{
+    memset(&_busStats, 0, sizeof(_busStats));
+    _busApi = DS3231_API_OTHER;
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::recordTransaction(uint32_t startUs, uint8_t bytes, bool nack, bool shortRead)
+{
+    uint32_t us = micros() - startUs;
+    uint8_t bin = 0;
+    while (us > 1 && bin < SODAQ_BUS_HIST_BINS - 1) {
+        us >>= 1;
+        bin++;
+    }
+    _busStats.durationHist[bin]++;
+
+    Sodaq_DS3231_ApiStats &api = _busStats.api[_busApi];
+    api.transactions++;
+    api.bytes += bytes;
+    if (nack) {
+        _busStats.nacks++;
+        api.nacks++;
+    }
+    if (shortRead) {
+        _busStats.shortReads++;
+        api.shortReads++;
+    }
+}
+#endif
+
+template <class Bus, uint8_t Address>
+uint8_t Sodaq_DS3231T<Bus, Address>::begin(void) {
+  SODAQ_DS3231_CALL(DS3231_API_BEGIN);
+
+  unsigned char ctReg=0;
+
+  Bus::begin();
+  ctReg |= 0b00011100;
+  writeRegister(DS3231_CONTROL_REG, ctReg);     //CONTROL Register Address
+  delay(10);
+
+  // set the clock to 24hr format
+  uint8_t hrReg = readRegister(DS3231_HOUR_REG);
+  hrReg &= 0b10111111;
+  writeRegister(DS3231_HOUR_REG, hrReg);
+
+  delay(10);
+
+  return _status == DS3231_OK;
+}
+
+//set the time-date specified in DateTime format
+//writing any non-existent time-data may interfere with normal operation of the RTC
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::setDateTime(const DateTime& dt) {
+  SODAQ_DS3231_CALL(DS3231_API_SET_DATE_TIME);
+  uint8_t buf[RTC_TIME_BLOCK_LEN];
+
+  RtcCodec<Ds3231Chip>::encode(dt, buf);   //Make sure clock is still 24 Hour
+  writeRegisters(DS3231_SEC_REG, buf, sizeof(buf));  //beginning from SEC Register address
+  _clockAnchored = false;
+  _clockPhased = false;
+  return _status;
+}
+
+template <class Bus, uint8_t Address>
+DateTime Sodaq_DS3231T<Bus, Address>::makeDateTime(unsigned long t)
+{
+  if (t < EPOCH_TIME_OFF)
+    return DateTime(0);
+  return DateTime(t - EPOCH_TIME_OFF);
+}
+
+// Set the RTC using timestamp (seconds since epoch)
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::setEpoch(uint32_t ts)
+{
+  SODAQ_DS3231_CALL(DS3231_API_SET_DATE_TIME);
+  return setDateTime(makeDateTime(ts));
+}
+
+//Return the current time-date in DateTime format, from the cached clock
+//when it is enabled or else straight from the RTC
+template <class Bus, uint8_t Address>
+DateTime Sodaq_DS3231T<Bus, Address>::now() {
+  SODAQ_DS3231_CALL(DS3231_API_NOW);
+  if (_clockCache) {
+    uint16_t ms;
+    return DateTime((long)cachedY2k(ms));
+  }
+  return readNow();
+}
+
+//Read the current time-date from the RTC and return it in DateTime format
+template <class Bus, uint8_t Address>
+DateTime Sodaq_DS3231T<Bus, Address>::readNow() {
+  SODAQ_DS3231_CALL(DS3231_API_NOW);
+  uint8_t buf[RTC_TIME_BLOCK_LEN];
+  if (readRegisters(DS3231_SEC_REG, buf, sizeof(buf)) != DS3231_OK)
+    return DateTime();
+  // A glitched read can pass the bus checks and still decode to a date
+  // far off, e.g. 0xFF bytes
+  DateTime dt;
+  if (!RtcCodec<Ds3231Chip>::decode(buf, dt)) {
+    _status = DS3231_BAD_DATA;
+    return DateTime();
+  }
+  if (_cacheEnabled)
+    cacheRegisters(DS3231_SEC_REG, buf, sizeof(buf));
+  return dt;
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::now(DateTime &dt)
+{
+  SODAQ_DS3231_CALL(DS3231_API_NOW);
+  DateTime t = now();
+  if (_status == DS3231_OK)
+    dt = t;
+  return _status;
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::readNow(DateTime &dt)
+{
+  SODAQ_DS3231_CALL(DS3231_API_NOW);
+  DateTime t = readNow();
+  if (_status == DS3231_OK)
+    dt = t;
+  return _status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cached clock: now() is extrapolated from millis() between resyncs
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::enableClockCache(uint32_t resyncMs, uint16_t maxDriftMs)
+{
+    _clockCache = true;
+    _clockAnchored = false;
+    _clockPhased = false;
+    _resyncMaxMs = resyncMs < 1000 ? 1000 : resyncMs;
+    _resyncMs = _resyncMaxMs;
+    _maxDriftMs = maxDriftMs;
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::disableClockCache()
+{
+    _clockCache = false;
+}
+
+// Call from the interrupt handler of an edge that coincides with the seconds
+// update: the 1 Hz SQW output, or /INT with enableInterrupts(EverySecond).
+// Only records the time, all bus traffic is left to now().
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::clockEdge()
+{
+    _edgeMs = millis();
+    _edgePending = true;
+}
+
+// Blocking resync: poll the seconds register until it rolls over (up to a
+// second) and anchor the cached clock to that instant.
+template <class Bus, uint8_t Address>
+bool Sodaq_DS3231T<Bus, Address>::syncClock()
+{
+    SODAQ_DS3231_CALL(DS3231_API_SYNC_CLOCK);
+    uint8_t first;
+    uint8_t sec;
+    if (readRegisters(DS3231_SEC_REG, &first, 1) != DS3231_OK)
+        return false;
+    sec = first;
+    uint32_t startMs = millis();
+    while (sec == first) {
+        if (millis() - startMs > 1100)
+            return false;
+        delay(1);
+        if (readRegisters(DS3231_SEC_REG, &sec, 1) != DS3231_OK)
+            return false;
+    }
+    anchorClock(millis());
+    return _status == DS3231_OK;
+}
+
+// The RTC second started at edgeMs; read it and make it the new anchor.
+// The difference to the extrapolated time adapts the resync interval.
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::anchorClock(uint32_t edgeMs)
+{
+    uint32_t y2k = readNow().get();
+    if (_status != DS3231_OK)
+        return;
+    if (_clockAnchored && _clockPhased) {
+        int32_t predictedMs = (int32_t)(edgeMs - _anchorMs);
+        int32_t actualMs = (int32_t)(y2k - _anchorY2k) * 1000L;
+        _clockDriftMs = predictedMs - actualMs;
+        uint16_t absDrift = abs(_clockDriftMs) > 0xFFFF ? 0xFFFF : abs(_clockDriftMs);
+        if (absDrift > _maxDriftMs) {
+            _resyncMs = _resyncMs / 2 < 1000 ? 1000 : _resyncMs / 2;
+        } else if (absDrift < _maxDriftMs / 2) {
+            _resyncMs = _resyncMs > _resyncMaxMs / 2 ? _resyncMaxMs : _resyncMs * 2;
+        }
+    }
+    _anchorY2k = y2k;
+    _anchorMs = edgeMs;
+    _clockAnchored = true;
+    _clockPhased = true;
+}
+
+// Resync without an edge: read the time once and keep the extrapolated
+// millisecond phase while it agrees with the RTC second. Otherwise, or when
+// never anchored, the second starts now, which is late by less than a
+// second, and the next fresh edge re-anchors.
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::checkClock(uint32_t nowMs)
+{
+    uint32_t y2k = readNow().get();
+    if (_status != DS3231_OK)
+        return;
+    if (_clockAnchored) {
+        uint32_t secs = (nowMs - _anchorMs) / 1000;
+        _anchorY2k += secs;
+        _anchorMs += secs * 1000;
+        if (_anchorY2k == y2k)
+            return;
+    }
+    _anchorY2k = y2k;
+    _anchorMs = nowMs;
+    _clockAnchored = true;
+    _clockPhased = false;
+}
+
+// Seconds since 2000 and the millisecond within it, from the cached clock
+template <class Bus, uint8_t Address>
+uint32_t Sodaq_DS3231T<Bus, Address>::cachedY2k(uint16_t &ms)
+{
+    noInterrupts();
+    uint32_t edgeMs = _edgeMs;
+    bool edgePending = _edgePending;
+    _edgePending = false;
+    interrupts();
+
+    uint32_t nowMs = millis();
+    // An edge older than 900 ms may be followed by the next RTC update
+    bool edgeFresh = edgePending && (nowMs - edgeMs) < 900;
+    bool expired = !_clockAnchored || nowMs - _anchorMs >= _resyncMs;
+    if (edgeFresh && (expired || !_clockPhased)) {
+        anchorClock(edgeMs);
+    } else if (expired) {
+        checkClock(nowMs);
+    } else if (edgePending && _clockPhased) {
+        // Re-phase on the edge without touching the bus: the edge is a whole
+        // number of seconds after the anchor
+        uint32_t secs = (edgeMs - _anchorMs + 500) / 1000;
+        _anchorY2k += secs;
+        _anchorMs = edgeMs;
+    }
+    if (!_clockAnchored) {
+        ms = 0;
+        return 0;       // Never read, as now() on a failed read
+    }
+
+    uint32_t elapsed = millis() - _anchorMs;
+    ms = elapsed % 1000;
+    return _anchorY2k + elapsed / 1000;
+}
+
+// Seconds since the Unix epoch, with the millisecond fraction in ms
+template <class Bus, uint8_t Address>
+uint32_t Sodaq_DS3231T<Bus, Address>::getEpochMs(uint16_t &ms)
+{
+    SODAQ_DS3231_CALL(DS3231_API_SYNC_CLOCK);
+    if (!_clockCache) {
+        ms = 0;
+        return readNow().getEpoch();
+    }
+    return cachedY2k(ms) + EPOCH_TIME_OFF;
+}
+
+//Enable periodic interrupt at /INT pin. Supports only the level interrupt
+//for consistency with other /INT interrupts. All interrupts works like single-shot counter
+//Use refreshINTA() to re-enable interrupt.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::enableInterrupts(uint8_t periodicity)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+    beginRegisterBatch();
+
+    // Turn in Alarm 1 at the control register
+    unsigned char ctReg=0;
+    ctReg |= 0b00011101;  // Alarm 1 on
+    writeRegister(DS3231_CONTROL_REG, ctReg);     //CONTROL Register Address
+
+   switch(periodicity)
+   {
+       case EverySecond:
+       // Set all four alarm masks (on bit 7) - Alarm once per second
+       writeRegister(DS3231_AL1SEC_REG,  0b10000000 ); //Set A1M1
+       writeRegister(DS3231_AL1MIN_REG,  0b10000000 ); //Set A1M2
+       writeRegister(DS3231_AL1HOUR_REG, 0b10000000 ); //Set A1M3
+       writeRegister(DS3231_AL1WDAY_REG, 0b10000000 ); //Set A1M4
+
+       break;
+
+       case EveryMinute:
+       // Set 3 masks - Alarm when seconds match
+       // seconds = 0, thus alarms on the minute
+       writeRegister(DS3231_AL1SEC_REG,  0b00000000 ); //Clr A1M1
+       writeRegister(DS3231_AL1MIN_REG,  0b10000000 ); //Set A1M2
+       writeRegister(DS3231_AL1HOUR_REG, 0b10000000 ); //Set A1M3
+       writeRegister(DS3231_AL1WDAY_REG, 0b10000000 ); //Set A1M4
+
+       break;
+
+       case EveryHour:
+       // Set 2 masks - Alarm when minutes and seconds match
+       // seconds = 0 and minutes = 0, thus alarms on the hour
+       writeRegister(DS3231_AL1SEC_REG,  0b00000000 ); //Clr A1M1
+       writeRegister(DS3231_AL1MIN_REG,  0b00000000 ); //Clr A1M2
+       writeRegister(DS3231_AL1HOUR_REG, 0b10000000 ); //Set A1M3
+       writeRegister(DS3231_AL1WDAY_REG, 0b10000000 ); //Set A1M4
+
+       break;
+   }
+
+   commitRegisterBatch();
+   return _status;
+}
+
+// Enable HH/MM/SS interrupt on /INTA pin. All interrupts works like single-shot counter
+// This will only alarm ONE TIME PER DAY AT EXACT HH:MM:SS MATCH!!
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::enableInterrupts(uint8_t hh24, uint8_t mm, uint8_t ss)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+    beginRegisterBatch();
+
+    // Turn in Alarm 1 at the control register
+    unsigned char ctReg=0;
+    ctReg |= 0b00011101;
+    writeRegister(DS3231_CONTROL_REG, ctReg);
+
+    writeRegister(DS3231_AL1SEC_REG,  0b00000000 | bin2bcd(ss) ); //Clr AM1
+    writeRegister(DS3231_AL1MIN_REG,  0b00000000 | bin2bcd(mm)); //Clr AM2
+    writeRegister(DS3231_AL1HOUR_REG, (0b00000000 | (bin2bcd(hh24) & 0b10111111))); //Clr AM3
+    writeRegister(DS3231_AL1WDAY_REG, 0b10000000 ); //Set AM4 - Alarm when hours, minutes, and seconds match
+
+    commitRegisterBatch();
+    return _status;
+}
+
+
+// More flexible setting of interrupts
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::enableInterrupts(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24, uint8_t minutes, uint8_t seconds)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+    beginRegisterBatch();
+
+    unsigned char ctReg=0;
+    ctReg |= 0b00011101;  // Alarm 1 on
+    writeRegister(DS3231_CONTROL_REG, ctReg);     //CONTROL Register Address
+
+    uint8_t buf[4];
+    encodeDs3231Alarm1(alarmType, daydate, hh24, minutes, seconds, buf);
+    writeRegisters(DS3231_AL1SEC_REG, buf, sizeof(buf));
+
+    commitRegisterBatch();
+    return _status;
+}
+
+//Disable Interrupts. This is equivalent to begin() method.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::disableInterrupts()
+{
+    SODAQ_DS3231_CALL(DS3231_API_DISABLE_INTERRUPTS);
+    begin(); //Restore to initial value.
+    return _status;
+}
+
+//Turn off both alarm interrupts with one control register update, leaving
+//the square wave, 32kHz and time registers as they are.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::disableAlarms()
+{
+    SODAQ_DS3231_CALL(DS3231_API_DISABLE_INTERRUPTS);
+    uint8_t ctReg = readRegister(DS3231_CONTROL_REG);
+    if (_status == DS3231_OK && (ctReg & 0b00000011))
+        writeRegister(DS3231_CONTROL_REG, ctReg & 0b11111100);
+    return _status;
+}
+
+//Clears the interrrupt flag in status register.
+//This is equivalent to preparing the DS3231 /INT pin to high for MCU to get ready for recognizing the next INT0 interrupt
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::clearINTStatus()
+{
+    SODAQ_DS3231_CALL(DS3231_API_CLEAR_INT_STATUS);
+    // Clear interrupt flag
+    uint8_t statusReg = readRegister(DS3231_STATUS_REG);
+    statusReg &= 0b11111110;
+    writeRegister(DS3231_STATUS_REG, statusReg);
+    return _status;
+}
+
+// The alarm flags in status bits 1:0 only clear when written 0, so they are
+// written as 1 and left alone; the register copy keeps the values read,
+// except inside a batch, where it holds what the commit will write.
+#define DS3231_STATUS_KEEP_FLAGS    0b00000011
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::setSquareWave(SqwRate_t rate)
+{
+    SODAQ_DS3231_CALL(DS3231_API_SQUARE_WAVE);
+    uint8_t buf[2];     // Control and status, written in one burst
+    buf[0] = readRegister(DS3231_CONTROL_REG);
+    uint8_t stReg = readRegister(DS3231_STATUS_REG);
+    encodeDs3231SquareWave(rate, buf[0], stReg);
+    buf[1] = stReg | DS3231_STATUS_KEEP_FLAGS;
+    writeRegisters(DS3231_CONTROL_REG, buf, sizeof(buf));
+    if (_cacheEnabled && !_batchDepth)
+        _regs[DS3231_STATUS_REG] = stReg;
+    return _status;
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::enable32kHz(bool enable)
+{
+    SODAQ_DS3231_CALL(DS3231_API_SQUARE_WAVE);
+    uint8_t stReg = readRegister(DS3231_STATUS_REG) & ~0b00001000;
+    if (enable)
+        stReg |= 0b00001000;
+    writeRegister(DS3231_STATUS_REG, stReg | DS3231_STATUS_KEEP_FLAGS);
+    if (_cacheEnabled && !_batchDepth)
+        _regs[DS3231_STATUS_REG] = stReg;
+    return _status;
+}
+
+// CONV bit of the control register, set to force a temperature conversion
+#define DS3231_CONV_BIT     0b00100000
+// A conversion takes typically 125 ms and at most 200 ms (datasheet tCONV)
+#define DS3231_TCONV_MAX_MS 250
+
+//force temperature sampling and converting to registers. If this function is not used the temperature is sampled once 64 Sec.
+//With waitToFinish, block until the new value is in the registers, at most DS3231_TCONV_MAX_MS.
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::convertTemperature(bool waitToFinish)
+{
+    SODAQ_DS3231_CALL(DS3231_API_CONVERT_TEMPERATURE);
+    startTemperatureConversion();
+
+    //wait until CONV is cleared. Indicates new temperature value is available in register.
+    if (waitToFinish) {
+        uint32_t startMs = millis();
+        while (!pollTemperature() && _status == DS3231_OK
+                && millis() - startMs < DS3231_TCONV_MAX_MS) {
+            delay(10);
+        }
+    }
+    return _status;
+}
+
+// Set the CONV bit to start a conversion. Returns false if one is already running.
+template <class Bus, uint8_t Address>
+bool Sodaq_DS3231T<Bus, Address>::startTemperatureConversion()
+{
+    SODAQ_DS3231_CALL(DS3231_API_CONVERT_TEMPERATURE);
+    // CONV is cleared by the device, so always read it from the bus
+    uint8_t ctReg;
+    if (readRegisters(DS3231_CONTROL_REG, &ctReg, 1) != DS3231_OK)
+        return false;
+    _tempConverting = true;
+    if (ctReg & DS3231_CONV_BIT)
+        return false;
+    ctReg |= DS3231_CONV_BIT;
+    writeRegister(DS3231_CONTROL_REG, ctReg);
+    return true;
+}
+
+// One read of the control register. When the conversion has finished, fetch
+// the new temperature, call the ready callback and return true.
+template <class Bus, uint8_t Address>
+bool Sodaq_DS3231T<Bus, Address>::pollTemperature()
+{
+    SODAQ_DS3231_CALL(DS3231_API_CONVERT_TEMPERATURE);
+    if (!_tempConverting)
+        return true;
+
+    uint8_t ctReg;
+    if (readRegisters(DS3231_CONTROL_REG, &ctReg, 1) != DS3231_OK)
+        return false;
+    if (ctReg & DS3231_CONV_BIT)
+        return false;
+
+    _tempConverting = false;
+    if (_cacheEnabled)
+        cacheRegisters(DS3231_CONTROL_REG, &ctReg, 1);
+    int16_t quarters = readTemperatureQuarters();
+    if (_tempCallback && _status == DS3231_OK)
+        _tempCallback(quarters);
+    return true;
+}
+
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::onTemperatureReady(TemperatureCallback_t callback)
+{
+    _tempCallback = callback;
+}
+
+// Temperature in 1/4 deg C, served from the register cache when it is valid
+// and no conversion started here is still waiting for pollTemperature()
+template <class Bus, uint8_t Address>
+int16_t Sodaq_DS3231T<Bus, Address>::getTemperatureQuarters()
+{
+    SODAQ_DS3231_CALL(DS3231_API_GET_TEMPERATURE);
+    if (_cacheEnabled && _cacheValid && !_tempConverting)
+        return temperatureQuarters(&_regs[DS3231_TMP_UP_REG]);
+    return readTemperatureQuarters();
+}
+
+// Read the MSB and LSB in one burst so they can't come from different conversions
+template <class Bus, uint8_t Address>
+int16_t Sodaq_DS3231T<Bus, Address>::readTemperatureQuarters()
+{
+    uint8_t buf[2];
+    if (readRegisters(DS3231_TMP_UP_REG, buf, sizeof(buf)) == DS3231_OK && _cacheEnabled)
+        cacheRegisters(DS3231_TMP_UP_REG, buf, sizeof(buf));
+    return temperatureQuarters(buf);
+}
+
+// The temperature registers hold a 10-bit two's complement value, the
+// integer part in the MSB and the quarters in bits 7:6 of the LSB
+template <class Bus, uint8_t Address>
+int16_t Sodaq_DS3231T<Bus, Address>::temperatureQuarters(const uint8_t *buf)
+{
+    return (int16_t)((int8_t)buf[0]) * 4 + (buf[1] >> 6);
+}
+
+template <class Bus, uint8_t Address>
+int8_t Sodaq_DS3231T<Bus, Address>::getAgingOffset()
+{
+    SODAQ_DS3231_CALL(DS3231_API_AGING_OFFSET);
+    return (int8_t)readRegister(DS3231_AGING_OFFSET_REG);
+}
+
+template <class Bus, uint8_t Address>
+Ds3231Status_t Sodaq_DS3231T<Bus, Address>::setAgingOffset(int8_t offset)
+{
+    SODAQ_DS3231_CALL(DS3231_API_AGING_OFFSET);
+    writeRegister(DS3231_AGING_OFFSET_REG, (uint8_t)offset);
+    startTemperatureConversion();
+    return _status;
+}
+
+//Read the temperature value from the register and convert it into float (deg C)
+template <class Bus, uint8_t Address>
+float Sodaq_DS3231T<Bus, Address>::getTemperature()
+{
+    SODAQ_DS3231_CALL(DS3231_API_GET_TEMPERATURE);
+    return getTemperatureQuarters() * 0.25f;
+}
+
+// Extension code placed here to keep compatibility from upstream fork.
+//#define Sodaq_DS3231_DEBUG
+#if defined Sodaq_DS3231_DEBUG
+#define SODAQ_DBG2(parm1,parm2)     Serial.print(parm1,HEX); Serial.print("/");Serial.print(parm2,HEX);Serial.print(", ")
+#define SODAQ_DBGT(parm1) Serial.print(parm1);
+#define SODAQ_DBGN(parm1) Serial.println(parm1);
+#else
+#define SODAQ_DBG2(parm1,parm2)     
+#define SODAQ_DBGT(parm1) 
+#define SODAQ_DBGN(parm1)
+#endif 
+
+#if defined(__AVR__)
+#define SODAQ_PROGMEM PROGMEM
+#define SDOAQ_rd_pgm(param1) pgm_read_byte_near(param1)
+#else
+#define SODAQ_PROGMEM
+#define SDOAQ_rd_pgm(param1) (*(param1))
+#endif
+
+#define DS3231_ALM1_SZ 4
+//Alarm1 has four consecutive registers  A1M1 A1M2 A1M3 A1M4
+const uint8_t alm1Ref_1second_pm[DS3231_ALM1_SZ] SODAQ_PROGMEM  = {0x80,0x80,0x80, 0x80};
+const uint8_t alm1Ref_1minute_pm[DS3231_ALM1_SZ] SODAQ_PROGMEM  = {0x00,0x80,0x80, 0x80};
+const uint8_t alm1Ref_1hour_pm[DS3231_ALM1_SZ]   SODAQ_PROGMEM  = {0x00,0x00,0x80, 0x80};
+
+//Enable periodic interrupt at /INT pin. Supports only the level interrupt
+//for consistency with other /INT interrupts. All interrupts works like single-shot counter
+//Use refreshINTA() to re-enable interrupt.
+//return 0 if true or else bit position of non-compliant register
+// Check the ALM1 is enabled in two reads 
+template <class Bus, uint8_t Address>
+uint8_t Sodaq_DS3231T<Bus, Address>::enableInterruptsCheckAlm1(uint8_t periodicity)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+
+    uint8_t cmp_result = 0;
+    uint8_t devReg;
+    uint8_t *p_almReg_pm= 0; //Pointer ref program space
+
+    SODAQ_DBGT("SODAQalm1 reg/diff ");  
+
+    //Check CONTROL_REG
+    #define DS3231_ALM1_EN 0b00000101
+    readRegisters(DS3231_CONTROL_REG, &devReg, 1);
+    devReg &= DS3231_ALM1_EN;
+    cmp_result |= ( (bool)( devReg ^ DS3231_ALM1_EN )?  0x01:0); //
+    SODAQ_DBG2(devReg,cmp_result);
+
+    switch(periodicity)
+    {    
+        case EverySecond: p_almReg_pm =(uint8_t *)alm1Ref_1second_pm; break;
+        case EveryMinute: p_almReg_pm =(uint8_t *)alm1Ref_1minute_pm; break;
+        case EveryHour: p_almReg_pm   =(uint8_t *)alm1Ref_1hour_pm;   break;        
+    }
+    if (0==p_almReg_pm) {
+        SODAQ_DBGT(periodicity);
+        SODAQ_DBGN(" invalid periodicity!");
+        return 0xFF;
+    }
+
+    //Check the ALM1 Regs by reading 4 consecutive registers
+    uint8_t almRegs[DS3231_ALM1_SZ];
+    if (readRegisters(DS3231_AL1SEC_REG, almRegs, DS3231_ALM1_SZ) == DS3231_OK) {
+        devReg =almRegs[0];
+        cmp_result |= ( (bool)( devReg ^ SDOAQ_rd_pgm(&p_almReg_pm[0]) )?  0x02:0); //07 Check Seconds
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[1];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[1]) )? 0x04:0); //08 Check Minutes    
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[2];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[2]) )? 0x08:0); //09 Check Hours
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[3];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[3]) )? 0x10:0); //0A Check Day   
+        SODAQ_DBG2(devReg,cmp_result);
+        SODAQ_DBGN("");
+    } else {
+        // Registers that couldn't be read aren't known to comply
+        cmp_result |= 0x1E;
+        SODAQ_DBGN(" not read!");
+    }
+
+   return cmp_result;
+}
+
+#define DS3231_ALM2_SZ 4
+//Alarm2 has four consecutive registers A2M2 A2M3 A2M4 Control  
+const uint8_t alm2Ref_1minute_pm[DS3231_ALM2_SZ] SODAQ_PROGMEM  = {0x80,0x80, 0x80, 0b00000110};
+const uint8_t alm2Ref_1hour_pm[DS3231_ALM2_SZ]   SODAQ_PROGMEM  = {0x00,0x80, 0x80, 0b00000110};
+
+// Check the ALM2 is enabled in one multi-byte read 
+template <class Bus, uint8_t Address>
+uint8_t Sodaq_DS3231T<Bus, Address>::enableInterruptsCheckAlm2(uint8_t periodicity)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+    uint8_t cmp_result = 0;
+    uint8_t devReg;
+    uint8_t *p_almReg_pm= 0; //Pointer ref program space
+
+    SODAQ_DBGT("SODAQalm2 reg/diff ");  
+
+    switch(periodicity)
+    {    
+        //case EverySecond: p_almReg_pm =(uint8_t *)alm1Ref_1second_pm; break;
+        case EveryMinute: p_almReg_pm =(uint8_t *)alm2Ref_1minute_pm; break;
+        case EveryHour: p_almReg_pm   =(uint8_t *)alm2Ref_1hour_pm;   break;    
+    }
+    if (0==p_almReg_pm) {
+        SODAQ_DBGT(periodicity);
+        SODAQ_DBGN(F(" invalid periodicity!"));
+        return 0xFF;
+    }
+
+    //Read the ALM2 + CONTROL Regs
+    uint8_t almRegs[DS3231_ALM2_SZ];
+    if (readRegisters(DS3231_AL2MIN_REG, almRegs, DS3231_ALM2_SZ) == DS3231_OK) {
+        devReg =almRegs[0];
+        cmp_result |= ( (bool)( devReg ^ SDOAQ_rd_pgm(&p_almReg_pm[0]) )?  0x04:0); //0B Check Minutes
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[1];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[1]) )? 0x08:0); //0C Check Hours    
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[2];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[2]) )? 0x10:0); //0D Check Hours
+        SODAQ_DBG2(devReg,cmp_result);
+        devReg =almRegs[3];
+        cmp_result |= ( (bool)( devReg  ^ SDOAQ_rd_pgm(&p_almReg_pm[3]) )? 0x01:0); //0E Check Control   
+        SODAQ_DBG2(devReg,cmp_result);
+        SODAQ_DBGN("");
+    } else {
+        // Registers that couldn't be read aren't known to comply
+        cmp_result |= 0x1D;
+        SODAQ_DBGN(" not read!");
+    }
+
+   return cmp_result;
+}
+
+//Enable periodic interrupt at /INT pin. Supports only the level interrupt
+//for consistency with other /INT interrupts. All interrupts works like single-shot counter
+//Use enableInterruptsCheckAlm2 for already setup interrupts
+// Practical note: this didn't creae an interrupt when tested. Alm1 worked
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::enableInterruptsAlm2(uint8_t periodicity)
+{
+    SODAQ_DS3231_CALL(DS3231_API_ENABLE_INTERRUPTS);
+    uint8_t *p_almReg_pm= 0; //Pointer ref program space
+
+    SODAQ_DBGT("SODAQenInt alm2 ");  
+    switch(periodicity)
+    {    
+        case EveryMinute: p_almReg_pm =(uint8_t *)alm2Ref_1minute_pm; break;
+        case EveryHour: p_almReg_pm   =(uint8_t *)alm2Ref_1hour_pm;   break;    
+    }
+    if (0==p_almReg_pm) {
+        SODAQ_DBGT(periodicity);
+        SODAQ_DBGN(F(" invalid periodicity!"));
+        return;
+    }
+    writeRegister_pm(DS3231_AL2MIN_REG,p_almReg_pm,DS3231_ALM2_SZ);
+}
+
+//Write a constant buffer from program space
+template <class Bus, uint8_t Address>
+void Sodaq_DS3231T<Bus, Address>::writeRegister_pm(uint8_t regaddress, uint8_t *buf, uint8_t len)
+{
+    uint8_t ram_buf[DS3231_ALM2_SZ];
+    if (len > sizeof(ram_buf)) len = sizeof(ram_buf);
+    for (uint8_t buf_lp=0; buf_lp<len;buf_lp++) {
+        ram_buf[buf_lp] = SDOAQ_rd_pgm(&buf[buf_lp]);
+    }
+    writeRegisters(regaddress, ram_buf, len);
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,218 @@
+// DateTime conversions over arrays, see Sodaq_DateTimeBatch.h
+
+#include "Sodaq_DateTimeBatch.h"
+
+#if !defined(ARDUINO)
+#include <thread>
+#include <vector>
+#endif
+
+using namespace sodaq_DS3231_nm;
+
+// The steps of the DateTime(long) constructor, in 32 bit lanes. Kept free of
+// calls and early exits so the loop vectorises.
+template <bool Epoch>
+void DateTimeBatch::convert(const uint32_t *__restrict__ in, size_t n, uint16_t *__restrict__ year,
+                            uint8_t *__restrict__ month, uint8_t *__restrict__ date,
+                            uint8_t *__restrict__ hour, uint8_t *__restrict__ minute,
+                            uint8_t *__restrict__ second, uint8_t *__restrict__ wday)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint32_t t = in[i];
+        if (Epoch)
+            t = t < EPOCH_TIME_OFF ? 0 : t - EPOCH_TIME_OFF;
+        uint32_t days = t / (uint32_t)SECONDS_PER_DAY;
+        uint32_t sod = t - days * (uint32_t)SECONDS_PER_DAY;
+        uint32_t hh = sod / 3600;
+        uint32_t soh = sod - hh * 3600;
+        uint32_t mm = soh / 60;
+
+        // Jan/Feb 2000 precede the 2000-03-01 base; the selects are written
+        // as arithmetic, which the vectoriser if-converts
+        uint32_t early = days < 31 + 29;
+        uint32_t feb = days >= 31;
+        uint32_t doe = early ? 0 : days - (31 + 29);
+        uint32_t yoe = DateTime::civilYoe(doe);
+        uint32_t doy = DateTime::civilDoy(doe, yoe);
+        uint32_t mp = DateTime::civilMp(doy);
+        uint32_t janFeb = mp >= 10;
+
+        year[i] = 2000 + (early ? 0 : yoe + janFeb);
+        month[i] = early ? 1 + feb : mp + 3 - 12 * janFeb;
+        date[i] = early ? days + 1 - 31 * feb : doy - (153 * mp + 2) / 5 + 1;
+        hour[i] = hh;
+        minute[i] = mm;
+        second[i] = soh - mm * 60;
+        wday[i] = (days + 6) % 7 + 1;
+    }
+}
+
+template <bool Epoch>
+void DateTimeBatch::convert(const uint32_t *in, size_t n, const DateTimeColumns &out)
+{
+    convert<Epoch>(in, n, out.year, out.month, out.date, out.hour, out.minute, out.second,
+                   out.dayOfWeek);
+}
+
+void DateTimeBatch::fromY2k(const uint32_t *y2k, size_t n, const DateTimeColumns &out)
+{
+    convert<false>(y2k, n, out);
+}
+
+void DateTimeBatch::fromEpoch(const uint32_t *epoch, size_t n, const DateTimeColumns &out)
+{
+    convert<true>(epoch, n, out);
+}
+
+// Length of one formatted time, 0 if it and its NUL don't fit in stride
+static size_t recordLength(DateTimeFormat_t fmt, size_t stride)
+{
+    char probe[DT_FMT_MAX_LEN + 1];
+    size_t len = DateTime().format(probe, sizeof(probe), fmt);
+    return len < stride ? len : 0;
+}
+
+// Converted a chunk at a time into columns on the stack, then written out
+// by DateTime::format(), so the text is the device's to the byte
+size_t DateTimeBatch::formatY2k(const uint32_t *y2k, size_t n, DateTimeFormat_t fmt,
+                                char *text, size_t stride)
+{
+    uint16_t year[DT_BATCH_CHUNK];
+    uint8_t month[DT_BATCH_CHUNK], date[DT_BATCH_CHUNK], hour[DT_BATCH_CHUNK];
+    uint8_t minute[DT_BATCH_CHUNK], second[DT_BATCH_CHUNK], wday[DT_BATCH_CHUNK];
+    DateTimeColumns cols = { year, month, date, hour, minute, second, wday };
+
+    size_t len = recordLength(fmt, stride);
+    if (!len)
+        return 0;
+    for (size_t done = 0; done < n; done += DT_BATCH_CHUNK) {
+        size_t count = n - done < DT_BATCH_CHUNK ? n - done : DT_BATCH_CHUNK;
+        fromY2k(y2k + done, count, cols);
+        char *p = text + done * stride;
+        for (size_t i = 0; i < count; i++, p += stride)
+            DateTime(year[i], month[i], date[i], hour[i], minute[i], second[i], wday[i])
+                .format(p, stride, fmt);
+    }
+    return len;
+}
+
+#if !defined(ARDUINO)
+// An output array the threads write, to keep them off each other's cache lines
+struct BatchColumn {
+    uintptr_t base;
+    size_t size;    // Bytes per element
+};
+
+// Elements [from, to) that share a cache line with the slice boundary at
+// element b in any column; an empty range when every column has a line
+// starting at b, e.g. with 64 byte aligned arrays
+static void sharedLines(const BatchColumn *cols, size_t ncols, size_t b, size_t n,
+                        size_t &from, size_t &to)
+{
+    from = to = b;
+    for (size_t c = 0; c < ncols; c++) {
+        uintptr_t addr = cols[c].base + b * cols[c].size;
+        uintptr_t line = addr & ~(uintptr_t)(DT_BATCH_LINE - 1);
+        if (line == addr)
+            continue;
+        size_t first = (line - cols[c].base) / cols[c].size;
+        size_t last = (line + DT_BATCH_LINE - cols[c].base + cols[c].size - 1) / cols[c].size;
+        if (first < from)
+            from = first;
+        if (last > to)
+            to = last < n ? last : n;
+    }
+}
+
+// Run fn(first, count) over [0, n), one DT_BATCH_CHUNK aligned slice per
+// thread. Elements on a cache line two slices share are left out and done
+// by the calling thread once the others are joined, so no two threads write
+// the same line of cols whatever their alignment. The calling thread takes
+// the last slice.
+template <class Fn>
+static void parallelChunks(size_t n, unsigned threads, const BatchColumn *cols, size_t ncols,
+                           Fn fn)
+{
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    size_t chunks = (n + DT_BATCH_CHUNK - 1) / DT_BATCH_CHUNK;
+    if (threads > chunks)
+        threads = chunks;
+    if (threads <= 1) {
+        fn(0, n);
+        return;
+    }
+    size_t per = (chunks + threads - 1) / threads * DT_BATCH_CHUNK;
+    std::vector<std::thread> workers;
+    std::vector<size_t> shared;     // from, to of each boundary
+    size_t first = 0;
+    for (size_t b = per; b < n; b += per) {
+        size_t from, to;
+        sharedLines(cols, ncols, b, n, from, to);
+        workers.emplace_back(fn, first, from - first);
+        shared.push_back(from);
+        shared.push_back(to);
+        first = to;
+    }
+    fn(first, n - first);
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    for (size_t i = 0; i < shared.size(); i += 2)
+        if (shared[i + 1] > shared[i])
+            fn(shared[i], shared[i + 1] - shared[i]);
+}
+
+// Columns starting at element first
+static DateTimeColumns offsetColumns(const DateTimeColumns &cols, size_t first)
+{
+    DateTimeColumns sub = { cols.year + first, cols.month + first, cols.date + first,
+                            cols.hour + first, cols.minute + first, cols.second + first,
+                            cols.dayOfWeek + first };
+    return sub;
+}
+
+// The arrays fromY2k() and fromEpoch() write
+static void outputColumns(const DateTimeColumns &out, BatchColumn *cols)
+{
+    cols[0].base = (uintptr_t)out.year;
+    cols[0].size = sizeof(*out.year);
+    uint8_t *bytes[] = { out.month, out.date, out.hour, out.minute, out.second, out.dayOfWeek };
+    for (size_t c = 0; c < 6; c++) {
+        cols[1 + c].base = (uintptr_t)bytes[c];
+        cols[1 + c].size = 1;
+    }
+}
+
+void DateTimeBatch::fromY2kParallel(const uint32_t *y2k, size_t n, const DateTimeColumns &out,
+                                    unsigned threads)
+{
+    BatchColumn cols[7];
+    outputColumns(out, cols);
+    parallelChunks(n, threads, cols, 7, [&](size_t first, size_t count) {
+        convert<false>(y2k + first, count, offsetColumns(out, first));
+    });
+}
+
+void DateTimeBatch::fromEpochParallel(const uint32_t *epoch, size_t n, const DateTimeColumns &out,
+                                      unsigned threads)
+{
+    BatchColumn cols[7];
+    outputColumns(out, cols);
+    parallelChunks(n, threads, cols, 7, [&](size_t first, size_t count) {
+        convert<true>(epoch + first, count, offsetColumns(out, first));
+    });
+}
+
+size_t DateTimeBatch::formatY2kParallel(const uint32_t *y2k, size_t n, DateTimeFormat_t fmt,
+                                        char *text, size_t stride, unsigned threads)
+{
+    size_t len = recordLength(fmt, stride);
+    if (!len)
+        return 0;
+    BatchColumn cols[1] = { { (uintptr_t)text, stride } };
+    parallelChunks(n, threads, cols, 1, [&](size_t first, size_t count) {
+        formatY2k(y2k + first, count, fmt, text + first * stride, stride);
+    });
+    return len;
+}
+#endif
@@ -0,0 +1,87 @@
+// DateTime conversions over arrays, e.g. to replay months of logger output
+// on a PC with the same calendar math as the device.
+//
+// The calendar fields go to one array each (structure of arrays), and no
+// element depends on another, so compilers vectorise the conversion loop
+// (GCC at -O3, wider with -march=native). Every element matches DateTime(long)
+// for the same seconds.
+//
+//   uint16_t year[N]; uint8_t month[N], date[N], hour[N], minute[N], second[N], wday[N];
+//   DateTimeColumns cols = { year, month, date, hour, minute, second, wday };
+//   DateTimeBatch::fromY2k(y2k, N, cols);
+//
+// On a host (ARDUINO not defined) the *Parallel() variants split the arrays
+// into slices converted by std::thread workers; link with -pthread. Elements
+// on a cache line two slices share are converted after the workers finish,
+// so threads never write the same line.
+
+#ifndef SODAQ_DATETIMEBATCH_H
+#define SODAQ_DATETIMEBATCH_H
+
+#include "Sodaq_DS3231.h"
+
+// Elements per chunk of formatY2k(), on its stack 8 bytes each. On a host
+// also the granularity of the parallel split.
+#ifndef DT_BATCH_CHUNK
+#if defined(__AVR__)
+#define DT_BATCH_CHUNK  16
+#else
+#define DT_BATCH_CHUNK  256
+#endif
+#endif
+
+// Cache line size the parallel split keeps threads apart on
+#ifndef DT_BATCH_LINE
+#define DT_BATCH_LINE   64
+#endif
+
+namespace sodaq_DS3231_nm {
+
+// Output arrays, n elements each
+struct DateTimeColumns {
+    uint16_t *year;
+    uint8_t *month;
+    uint8_t *date;
+    uint8_t *hour;
+    uint8_t *minute;
+    uint8_t *second;
+    uint8_t *dayOfWeek;     // 1 = Sunday, as DateTime::dayOfWeek()
+};
+
+struct DateTimeBatch {
+    // Seconds since 2000, as DateTime(long) and DateTime::get()
+    static void fromY2k(const uint32_t *y2k, size_t n, const DateTimeColumns &out);
+    // Unix seconds; times before 2000 give 2000-01-01 00:00:00, as
+    // Sodaq_DS3231::makeDateTime()
+    static void fromEpoch(const uint32_t *epoch, size_t n, const DateTimeColumns &out);
+
+    // Text of each time as DateTime::format(), record i at text + i * stride
+    // and NUL terminated. Returns the length of one record, or 0 when the
+    // format is unknown or a record doesn't fit in stride.
+    static size_t formatY2k(const uint32_t *y2k, size_t n, DateTimeFormat_t fmt,
+                            char *text, size_t stride);
+
+#if !defined(ARDUINO)
+    // threads = 0 uses one per hardware thread
+    static void fromY2kParallel(const uint32_t *y2k, size_t n, const DateTimeColumns &out,
+                                unsigned threads = 0);
+    static void fromEpochParallel(const uint32_t *epoch, size_t n, const DateTimeColumns &out,
+                                  unsigned threads = 0);
+    static size_t formatY2kParallel(const uint32_t *y2k, size_t n, DateTimeFormat_t fmt,
+                                    char *text, size_t stride, unsigned threads = 0);
+#endif
+
+private:
+    template <bool Epoch>
+    static void convert(const uint32_t *in, size_t n, const DateTimeColumns &out);
+    // __restrict__ is only honoured on parameters; without it every uint8_t
+    // store could alias the input
+    template <bool Epoch>
+    static void convert(const uint32_t *__restrict__ in, size_t n, uint16_t *__restrict__ year,
+                        uint8_t *__restrict__ month, uint8_t *__restrict__ date,
+                        uint8_t *__restrict__ hour, uint8_t *__restrict__ minute,
+                        uint8_t *__restrict__ second, uint8_t *__restrict__ wday);
+};
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,85 @@
+// I2C transports for the RTC drivers.
+//
+// The drivers take their bus as a template argument: a class with the
+// static functions below. Every call is resolved at compile time, so a
+// driver on Wire1 or on a software I2C costs the same as one on Wire.
+//
+//   struct MyBus {
+//       static void begin();
+//       static void beginTransmission(uint8_t address);
+//       static size_t write(uint8_t value);
+//       static uint8_t endTransmission();         // 0 on success, as TwoWire
+//       static uint8_t requestFrom(uint8_t address, uint8_t len);
+//       static int read();
+//       static void recover();                    // After a bus error
+//   };
+//
+// A recording mock for host tests only needs the same seven functions.
+
+#ifndef SODAQ_I2CBUS_H
+#define SODAQ_I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// How long TwoWire waits on a stuck bus before giving up with error 5, on
+// cores that support it (WIRE_HAS_TIMEOUT). Without it a slave holding SDA
+// or SCL low hangs the AVR Wire library.
+#ifndef SODAQ_I2C_TIMEOUT_US
+#define SODAQ_I2C_TIMEOUT_US    25000
+#endif
+
+namespace sodaq_DS3231_nm {
+
+// Free a slave that holds SDA low in the middle of a byte, e.g. after an
+// MCU reset during a read: clock SCL until it lets go (at most 9 pulses),
+// then send a STOP. The pins are driven open drain. See UM10204 3.1.16.
+inline void recoverI2cPins(uint8_t sda, uint8_t scl)
+{
+    pinMode(sda, INPUT_PULLUP);
+    pinMode(scl, INPUT_PULLUP);
+    for (uint8_t i = 0; i < 9 && digitalRead(sda) == LOW; i++) {
+        digitalWrite(scl, LOW);
+        pinMode(scl, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(scl, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+    digitalWrite(sda, LOW);
+    pinMode(sda, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(sda, INPUT_PULLUP);
+    delayMicroseconds(5);
+}
+
+// Any TwoWire instance, e.g. TwoWireBus<Wire1> for a second SERCOM
+template <TwoWire &W>
+struct TwoWireBus {
+    static void begin()
+    {
+        W.begin();
+#if defined(WIRE_HAS_TIMEOUT)
+        W.setWireTimeout(SODAQ_I2C_TIMEOUT_US, true);
+#endif
+    }
+    static void beginTransmission(uint8_t address) { W.beginTransmission(address); }
+    static size_t write(uint8_t value) { return W.write(value); }
+    static uint8_t endTransmission() { return W.endTransmission(); }
+    static uint8_t requestFrom(uint8_t address, uint8_t len) { return W.requestFrom(address, len); }
+    static int read() { return W.read(); }
+    // Only Wire has known pins (SDA, SCL), other instances are restarted
+    static void recover()
+    {
+        W.end();
+#if defined(SDA) && defined(SCL)
+        if (&W == &Wire)
+            recoverI2cPins(SDA, SCL);
+#endif
+        begin();
+    }
+};
+
+typedef TwoWireBus<Wire> WireBus;
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,70 @@
+// Local time from build-time DST tables, see Sodaq_LocalTime.h
+
+#include "Sodaq_LocalTime.h"
+
+using namespace sodaq_DS3231_nm;
+
+// An empty segment, so the first lookup fills it
+LocalTime::LocalTime(const TimeZone &zone)
+    : _zone(zone), _segStart(1), _segEnd(0), _segMinutes(zone.stdMinutes),
+      _nextMidnight(0), _dayStarted(false)
+{
+}
+
+uint32_t LocalTime::toUtc(uint32_t localY2k)
+{
+    uint32_t utc = localY2k - _zone.dstMinutes * 60L;
+    if (offsetMinutes(utc) == _zone.dstMinutes)
+        return utc;
+    return localY2k - _zone.stdMinutes * 60L;
+}
+
+uint32_t LocalTime::nextMidnight(uint32_t utcY2k)
+{
+    uint32_t local = toLocal(utcY2k);
+    // The offset at midnight may differ from the one now, toUtc() sorts it out
+    return toUtc(local - local % SECONDS_PER_DAY + SECONDS_PER_DAY);
+}
+
+// Find the stretch around utcY2k with one offset. It never reaches past the
+// UTC year of utcY2k, so the table is read at most once a year and at each
+// DST change.
+void LocalTime::findSegment(uint32_t utcY2k)
+{
+    uint16_t year = DateTime((long)utcY2k).year();
+    _segStart = (uint32_t)DateTime::date2days(year, 1, 1) * SECONDS_PER_DAY;
+    // 2136 is past the end of uint32_t seconds
+    _segEnd = year < 2135 ? (uint32_t)DateTime::date2days(year + 1, 1, 1) * SECONDS_PER_DAY
+                          : 0xFFFFFFFFUL;
+    _segMinutes = _zone.stdMinutes;
+    if (year < _zone.firstYear || year - _zone.firstYear >= _zone.years)
+        return;
+
+    const uint32_t *change = _zone.changes + 2 * (year - _zone.firstYear);
+    uint32_t dstStart = SODAQ_TZ_READ(change);
+    uint32_t dstEnd = SODAQ_TZ_READ(change + 1);
+    if (dstStart < dstEnd) {
+        // Northern hemisphere: standard, DST, standard
+        if (utcY2k < dstStart) {
+            _segEnd = dstStart;
+        } else if (utcY2k < dstEnd) {
+            _segStart = dstStart;
+            _segEnd = dstEnd;
+            _segMinutes = _zone.dstMinutes;
+        } else {
+            _segStart = dstEnd;
+        }
+    } else {
+        // Southern hemisphere: DST, standard, DST
+        if (utcY2k < dstEnd) {
+            _segEnd = dstEnd;
+            _segMinutes = _zone.dstMinutes;
+        } else if (utcY2k < dstStart) {
+            _segStart = dstEnd;
+            _segEnd = dstStart;
+        } else {
+            _segStart = dstStart;
+            _segMinutes = _zone.dstMinutes;
+        }
+    }
+}
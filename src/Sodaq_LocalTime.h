@@ -0,0 +1,97 @@
+// Local time and daylight saving from build-time time zone tables.
+//
+// The RTC keeps UTC. extras/tzgen.py turns a POSIX TZ string into a header
+// with the UTC instants of every DST change over a range of years, stored
+// in flash, and a TimeZone describing them:
+//
+//   python extras/tzgen.py "EST5EDT,M3.2.0,M11.1.0" tzEastern --first 2007 > tz_eastern.h
+//
+//   LocalTime local(tzEastern);
+//   DateTime dt = local.toLocal(rtc.now());
+//   if (local.dayChanged(rtc.now().get())) openNewLogFile();
+//
+// LocalTime remembers the stretch of the current year in which the offset
+// stays the same, and the next local midnight. Until a sample crosses one
+// of them a conversion is two compares and an add, with no table lookup or
+// calendar math. Outside the years of the table standard time applies.
+
+#ifndef SODAQ_LOCALTIME_H
+#define SODAQ_LOCALTIME_H
+
+#include "Sodaq_DS3231.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define SODAQ_TZ_PROGMEM        PROGMEM
+#define SODAQ_TZ_READ(p)        pgm_read_dword(p)
+#else
+#define SODAQ_TZ_PROGMEM
+#define SODAQ_TZ_READ(p)        (*(p))
+#endif
+
+namespace sodaq_DS3231_nm {
+
+// Written by extras/tzgen.py, see above
+struct TimeZone {
+    int16_t stdMinutes;         // Standard time, minutes east of UTC
+    int16_t dstMinutes;         // Daylight saving time, minutes east of UTC
+    uint16_t firstYear;         // Year of the first two changes
+    uint8_t years;              // Years in the table, 0 without DST
+    const uint32_t *changes;    // SODAQ_TZ_PROGMEM, per year the DST start
+                                // and end in UTC seconds since 2000
+    const char *stdName;
+    const char *dstName;
+};
+
+class LocalTime {
+public:
+    explicit LocalTime(const TimeZone &zone);
+
+    // Offset from UTC in minutes at utcY2k (seconds since 2000)
+    int16_t offsetMinutes(uint32_t utcY2k)
+    {
+        if (utcY2k < _segStart || utcY2k >= _segEnd)
+            findSegment(utcY2k);
+        return _segMinutes;
+    }
+    bool isDst(uint32_t utcY2k) { return offsetMinutes(utcY2k) != _zone.stdMinutes; }
+    const char *abbreviation(uint32_t utcY2k)
+    {
+        return isDst(utcY2k) ? _zone.dstName : _zone.stdName;
+    }
+
+    // Local seconds since 2000, as the DateTime constructor takes them
+    uint32_t toLocal(uint32_t utcY2k) { return utcY2k + offsetMinutes(utcY2k) * 60L; }
+    DateTime toLocal(const DateTime &utc) { return DateTime((long)toLocal(utc.get())); }
+    // Local time back to UTC. A local time skipped at the start of DST is
+    // taken as standard time; one repeated at the end as the first of the two.
+    uint32_t toUtc(uint32_t localY2k);
+
+    // UTC seconds since 2000 of the first local midnight after utcY2k
+    uint32_t nextMidnight(uint32_t utcY2k);
+    // True on the first call and then whenever utcY2k has passed a local
+    // midnight since the call that last returned true. Meant to be called
+    // for every sample, e.g. to start a new daily log file.
+    bool dayChanged(uint32_t utcY2k)
+    {
+        if (_dayStarted && utcY2k < _nextMidnight)
+            return false;
+        _dayStarted = true;
+        _nextMidnight = nextMidnight(utcY2k);
+        return true;
+    }
+
+private:
+    void findSegment(uint32_t utcY2k);
+
+    const TimeZone &_zone;
+    // [_segStart, _segEnd) in UTC has the offset _segMinutes
+    uint32_t _segStart;
+    uint32_t _segEnd;
+    int16_t _segMinutes;
+    uint32_t _nextMidnight;
+    bool _dayStarted;
+};
+
+} //namespace sodaq_DS3231_nm
+#endif
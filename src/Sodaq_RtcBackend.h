@@ -0,0 +1,484 @@
+// Compile-time RTC backend: one driver template, specialised per chip.
+//
+// The DS3231 and the PCF8523 keep the same BCD seconds..year block, only in
+// a different place and order. Each chip is described by a traits struct
+// (bus address, block position, field order and masks); RtcCodec<Chip>
+// converts the block to and from DateTime, and RtcDriver<Chip> adds the
+// bus access, square-wave and alarm control over any Bus (Sodaq_I2cBus.h).
+// Everything is static and resolved at compile time, there are no virtual calls.
+//
+//   typedef RtcDriver<Pcf8523Chip> BoardRtc;   // or RtcDriver<Ds3231Chip, TwoWireBus<Wire1> >
+//   DateTime dt = BoardRtc::now();
+//
+// Sodaq_DS3231 and RTC_PCF8523 use the same codecs, so both can be built
+// into one image.
+
+#ifndef SODAQ_RTCBACKEND_H
+#define SODAQ_RTCBACKEND_H
+
+#include "Sodaq_DS3231.h"
+#include "Sodaq_I2cBus.h"
+
+namespace sodaq_DS3231_nm {
+
+// Binary-Coded-Decimal (BCD)-to-Decimal conversion
+constexpr uint8_t bcd2bin (uint8_t val) { return val - 6 * (val >> 4); }
+// Decimal-to-BCD (Binary-Coded-Decimal) conversion
+constexpr uint8_t bin2bcd (uint8_t val) { return val + 6 * (val / 10); }
+
+struct Ds3231Chip {
+    enum {
+        ADDRESS = 0x68,
+        TIME_REG = 0x00,    // seconds..year block starts here
+        POS_SEC = 0, POS_MIN = 1, POS_HOUR = 2, POS_WDAY = 3,
+        POS_DATE = 4, POS_MONTH = 5, POS_YEAR = 6,
+        SEC_MASK = 0x7F,
+        HOUR_MASK = 0x3F,   // Ignore the 12/24 hour bit
+        MONTH_MASK = 0x1F,
+        CENTURY_BIT = 0x80, // In the month register, set for 2100..2199. The chip
+                            // itself counts 2100 as a leap year.
+    };
+};
+
+struct Pcf8523Chip {
+    enum {
+        ADDRESS = 0x68,
+        TIME_REG = 0x03,
+        POS_SEC = 0, POS_MIN = 1, POS_HOUR = 2, POS_DATE = 3,
+        POS_WDAY = 4, POS_MONTH = 5, POS_YEAR = 6,
+        SEC_MASK = 0x7F,    // Ignore the oscillator stop (OS) flag
+        HOUR_MASK = 0x3F,
+        MONTH_MASK = 0x1F,
+        CENTURY_BIT = 0,    // None, the year register covers 2000..2099
+    };
+};
+
+#define RTC_TIME_BLOCK_LEN  7
+
+// SWAR (SIMD within a register) BCD arithmetic: every byte of a word is
+// converted at once, byte 0 in the low bits. On a 64 bit host the whole
+// time block fits one word. The AVR has no 64 bit shifts or multiplies,
+// so there the block takes two 32 bit words.
+#if defined(__AVR__)
+typedef uint32_t rtc_swar_t;
+#else
+typedef uint64_t rtc_swar_t;
+#endif
+
+template <class W>
+struct BcdSwar {
+    // b in every byte, h in every 16 bit half
+    static constexpr W bytes(uint8_t b) { return (W)~(W)0 / 0xFF * b; }
+    static constexpr W halves(uint16_t h) { return (W)~(W)0 / 0xFFFF * h; }
+
+    // BCD to binary in every byte. Nibbles above 9 give a wrong result,
+    // badBcd() finds them.
+    static W toBin(W w)
+    {
+        W tens = (w >> 4) & bytes(0x0F);
+        return (w & bytes(0x0F)) + (tens << 3) + (tens << 1);
+    }
+    // Binary 0..99 to BCD in every byte. The bytes are spread over 16 bit
+    // lanes, where x / 10 is (x * 103) >> 10 without spilling into the next.
+    static W toBcd(W w)
+    {
+        return toBcd16(w & halves(0x00FF)) | (toBcd16((w >> 8) & halves(0x00FF)) << 8);
+    }
+    // Bit 7 set in every byte with a nibble above 9
+    static W badBcd(W w)
+    {
+        W lo = (w & bytes(0x0F)) + bytes(0x06);
+        W hi = ((w >> 4) & bytes(0x0F)) + bytes(0x06);
+        return ((lo | hi) << 3) & bytes(0x80);
+    }
+    // Bit 7 set in every byte below its byte in lo or above its byte in hi.
+    // All bytes must be 0..0x7F, so no carry or borrow crosses into the next.
+    static W outOfRange(W w, W lo, W hi)
+    {
+        W below = ((w | bytes(0x80)) - lo) ^ bytes(0x80);
+        W above = w + (bytes(0x7F) - hi);
+        return (below | above) & bytes(0x80);
+    }
+
+private:
+    static W toBcd16(W x)
+    {
+        W tens = ((x * 103) >> 10) & halves(0x000F);
+        return x + (tens << 2) + (tens << 1);
+    }
+};
+
+// Converts the seconds..year block to and from DateTime. The block is
+// decoded, range checked and encoded as whole words, see BcdSwar. The
+// *Bytewise() versions do the same one register at a time; they are kept
+// as the reference for the benchmarks.
+template <class Chip>
+struct RtcCodec {
+    typedef BcdSwar<rtc_swar_t> Swar;
+    enum { WORD_LEN = sizeof(rtc_swar_t),
+           WORDS = (RTC_TIME_BLOCK_LEN + WORD_LEN - 1) / WORD_LEN };
+
+    // Decode into dt and return true when every field of the block is BCD
+    // and in range. A read from a disturbed bus gives 0xFF or 0x00 bytes,
+    // which fail here.
+    static bool decode(const uint8_t *buf, DateTime &dt)
+    {
+        rtc_swar_t bin[WORDS];
+        bool ok = unpack(buf, bin);
+        dt = DateTime(lane(bin, Chip::POS_YEAR) + 2000
+                          + ((buf[Chip::POS_MONTH] & Chip::CENTURY_BIT) ? 100 : 0),
+                      lane(bin, Chip::POS_MONTH),
+                      lane(bin, Chip::POS_DATE),
+                      lane(bin, Chip::POS_HOUR),
+                      lane(bin, Chip::POS_MIN),
+                      lane(bin, Chip::POS_SEC),
+                      buf[Chip::POS_WDAY]);
+        return ok;
+    }
+    static DateTime decode(const uint8_t *buf)
+    {
+        DateTime dt;
+        decode(buf, dt);
+        return dt;
+    }
+    static bool valid(const uint8_t *buf)
+    {
+        rtc_swar_t bin[WORDS];
+        return unpack(buf, bin);
+    }
+    // The hour is always written in 24 hour format. Without a century bit
+    // only the last two digits of the year are kept.
+    static void encode(const DateTime &dt, uint8_t *buf)
+    {
+        rtc_swar_t bin[WORDS] = {};
+        setLane(bin, Chip::POS_SEC, dt.second());
+        setLane(bin, Chip::POS_MIN, dt.minute());
+        setLane(bin, Chip::POS_HOUR, dt.hour());
+        setLane(bin, Chip::POS_DATE, dt.date());
+        setLane(bin, Chip::POS_MONTH, dt.month());
+        setLane(bin, Chip::POS_YEAR, dt.year2k() % 100);
+        for (uint8_t i = 0; i < WORDS; i++)
+            storeWord(Swar::toBcd(bin[i]), buf, i);
+        buf[Chip::POS_WDAY] = dt.dayOfWeek();
+        if (dt.year2k() >= 100)
+            buf[Chip::POS_MONTH] |= Chip::CENTURY_BIT;
+    }
+
+    static DateTime decodeBytewise(const uint8_t *buf)
+    {
+        return DateTime(bcd2bin(buf[Chip::POS_YEAR]) + 2000
+                            + ((buf[Chip::POS_MONTH] & Chip::CENTURY_BIT) ? 100 : 0),
+                        bcd2bin(buf[Chip::POS_MONTH] & Chip::MONTH_MASK),
+                        bcd2bin(buf[Chip::POS_DATE]),
+                        bcd2bin(buf[Chip::POS_HOUR] & Chip::HOUR_MASK),
+                        bcd2bin(buf[Chip::POS_MIN]),
+                        bcd2bin(buf[Chip::POS_SEC] & Chip::SEC_MASK),
+                        buf[Chip::POS_WDAY]);
+    }
+    static bool validBytewise(const uint8_t *buf)
+    {
+        return validBcd(buf[Chip::POS_SEC] & Chip::SEC_MASK, 0x00, 0x59)
+            && validBcd(buf[Chip::POS_MIN], 0x00, 0x59)
+            && validBcd(buf[Chip::POS_HOUR] & Chip::HOUR_MASK, 0x00, 0x23)
+            && validBcd(buf[Chip::POS_DATE], 0x01, 0x31)
+            && validBcd(buf[Chip::POS_MONTH] & Chip::MONTH_MASK, 0x01, 0x12)
+            && validBcd(buf[Chip::POS_YEAR], 0x00, 0x99);
+    }
+    static bool validBcd(uint8_t val, uint8_t lo, uint8_t hi)
+    {
+        return (val & 0x0F) <= 9 && val >= lo && val <= hi;
+    }
+    static void encodeBytewise(const DateTime &dt, uint8_t *buf)
+    {
+        buf[Chip::POS_SEC] = bin2bcd(dt.second());
+        buf[Chip::POS_MIN] = bin2bcd(dt.minute());
+        buf[Chip::POS_HOUR] = bin2bcd(dt.hour()) & Chip::HOUR_MASK;
+        buf[Chip::POS_WDAY] = dt.dayOfWeek();
+        buf[Chip::POS_DATE] = bin2bcd(dt.date());
+        buf[Chip::POS_MONTH] = bin2bcd(dt.month()) | (dt.year2k() >= 100 ? Chip::CENTURY_BIT : 0);
+        buf[Chip::POS_YEAR] = bin2bcd(dt.year2k() % 100);
+    }
+
+private:
+    enum LaneConst { LANE_MASK, LANE_MIN, LANE_MAX };
+
+    // Per register: the bits that hold the value and its valid range. The
+    // weekday and the bytes past the block are masked out.
+    static constexpr uint8_t laneConst(LaneConst kind, uint8_t pos)
+    {
+        return pos == Chip::POS_SEC   ? (kind == LANE_MASK ? Chip::SEC_MASK : kind == LANE_MIN ? 0 : 59)
+             : pos == Chip::POS_MIN   ? (kind == LANE_MASK ? 0xFF : kind == LANE_MIN ? 0 : 59)
+             : pos == Chip::POS_HOUR  ? (kind == LANE_MASK ? Chip::HOUR_MASK : kind == LANE_MIN ? 0 : 23)
+             : pos == Chip::POS_DATE  ? (kind == LANE_MASK ? 0xFF : kind == LANE_MIN ? 1 : 31)
+             : pos == Chip::POS_MONTH ? (kind == LANE_MASK ? Chip::MONTH_MASK : kind == LANE_MIN ? 1 : 12)
+             : pos == Chip::POS_YEAR  ? (kind == LANE_MASK ? 0xFF : kind == LANE_MIN ? 0 : 99)
+             : 0;
+    }
+    static constexpr rtc_swar_t packConst(LaneConst kind, uint8_t word, uint8_t b = 0)
+    {
+        return b == WORD_LEN ? 0
+             : ((rtc_swar_t)laneConst(kind, word * WORD_LEN + b) << (8 * b))
+                   | packConst(kind, word, b + 1);
+    }
+    // Kept in a table so they are folded at compile time. The block takes
+    // one or two words.
+    static_assert(WORDS <= 2, "RTC time block longer than two words");
+    static constexpr rtc_swar_t LANES[3][2] = {
+        { packConst(LANE_MASK, 0), packConst(LANE_MASK, 1) },
+        { packConst(LANE_MIN, 0), packConst(LANE_MIN, 1) },
+        { packConst(LANE_MAX, 0), packConst(LANE_MAX, 1) },
+    };
+
+    // Masked binary fields of the block into bin, true when all are valid
+    static bool unpack(const uint8_t *buf, rtc_swar_t *bin)
+    {
+        rtc_swar_t bad = 0;
+        for (uint8_t i = 0; i < WORDS; i++) {
+            rtc_swar_t w = loadWord(buf, i) & LANES[LANE_MASK][i];
+            bad |= Swar::badBcd(w);
+            // Bad BCD can decode above 0x7F; it has failed already
+            bin[i] = Swar::toBin(w) & Swar::bytes(0x7F);
+            bad |= Swar::outOfRange(bin[i], LANES[LANE_MIN][i], LANES[LANE_MAX][i]);
+        }
+        return bad == 0;
+    }
+    // Word i of the block, byte 0 lowest. Past the block the bytes are 0.
+    static uint8_t wordLen(uint8_t i)
+    {
+        return i + 1 < WORDS ? WORD_LEN : RTC_TIME_BLOCK_LEN - i * WORD_LEN;
+    }
+    static rtc_swar_t loadWord(const uint8_t *buf, uint8_t i)
+    {
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+        rtc_swar_t w = 0;
+        for (uint8_t b = 0; b < wordLen(i); b++)
+            w |= (rtc_swar_t)buf[i * WORD_LEN + b] << (8 * b);
+        return w;
+#elif defined(__AVR__)
+        rtc_swar_t w = 0;
+        memcpy(&w, buf + i * WORD_LEN, wordLen(i));
+        return w;
+#else
+        // Two overlapping 32 bit loads. A 7 byte memcpy() would go through
+        // the stack, and reading it back as one word stalls.
+        (void)i;    // The block is one word
+        uint32_t lo, hi;
+        memcpy(&lo, buf, 4);
+        memcpy(&hi, buf + RTC_TIME_BLOCK_LEN - 4, 4);
+        return lo | (rtc_swar_t)hi << (8 * (RTC_TIME_BLOCK_LEN - 4));
+#endif
+    }
+    static void storeWord(rtc_swar_t w, uint8_t *buf, uint8_t i)
+    {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(buf + i * WORD_LEN, &w, wordLen(i));
+#else
+        for (uint8_t b = 0; b < wordLen(i); b++)
+            buf[i * WORD_LEN + b] = (uint8_t)(w >> (8 * b));
+#endif
+    }
+    static uint8_t lane(const rtc_swar_t *bin, uint8_t pos)
+    {
+        return (uint8_t)(bin[pos / WORD_LEN] >> (8 * (pos % WORD_LEN)));
+    }
+    static void setLane(rtc_swar_t *bin, uint8_t pos, uint8_t val)
+    {
+        bin[pos / WORD_LEN] |= (rtc_swar_t)val << (8 * (pos % WORD_LEN));
+    }
+};
+
+template <class Chip>
+constexpr rtc_swar_t RtcCodec<Chip>::LANES[3][2];
+
+// DS3231 Alarm 1 registers (seconds, minutes, hours, day/date) for an
+// ALARM_TYPES_t, with the A1Mx mask and DY/DT bits set as needed.
+inline void encodeDs3231Alarm1(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24,
+                               uint8_t minutes, uint8_t seconds, uint8_t *buf)
+{
+    buf[0] = bin2bcd(seconds);
+    buf[1] = bin2bcd(minutes);
+    buf[2] = bin2bcd(hh24);
+    buf[3] = bin2bcd(daydate);
+    if (alarmType & 0x01) buf[0] |= 0b10000000;  // To alarm every second, set the alarm mask on seconds
+    if (alarmType & 0x02) buf[1] |= 0b10000000;  // To match seconds, need to set the alarm mask on minutes
+    if (alarmType & 0x04) buf[2] |= 0b10000000;  // To match minutes *and* seconds, need to add the alarm mask on hours
+    if (alarmType & 0x10) buf[2] |= 0b01000000;  // To match day *and* hours, minutes, seconds, need clear all alarm masks, but set the DY/DT bit
+    if (alarmType & 0x08) buf[3] |= 0b10000000;  // To match hours *and* minutes, seconds, need to add the alarm mask on days
+    // To match date *and* hours, minutes, seconds, need no alarm masks or DY/DT bits
+}
+
+// Update the DS3231 control (0x0E) and status (0x0F) register values for a
+// square-wave rate: RS2:RS1 in control bits 4:3, INTCN in control bit 2 and
+// EN32kHz in status bit 3. SQW_32KHZ moves the output to the 32kHz pin.
+inline void encodeDs3231SquareWave(SqwRate_t rate, uint8_t &ctReg, uint8_t &stReg)
+{
+    ctReg &= ~0b00011100;
+    stReg &= ~0b00001000;
+    switch (rate) {
+        case SQW_1HZ:   break;
+        case SQW_1KHZ:  ctReg |= 0b00001000; break;
+        case SQW_4KHZ:  ctReg |= 0b00010000; break;
+        case SQW_8KHZ:  ctReg |= 0b00011000; break;
+        case SQW_32KHZ: ctReg |= 0b00000100; stReg |= 0b00001000; break;
+        default:        ctReg |= 0b00000100; break;
+    }
+}
+
+template <class Chip, class Bus = WireBus>
+class RtcDriver {
+public:
+    static void begin() { Bus::begin(); }
+
+    static DateTime now()
+    {
+        uint8_t buf[RTC_TIME_BLOCK_LEN];
+        readRegisters(Chip::TIME_REG, buf, sizeof(buf));
+        return RtcCodec<Chip>::decode(buf);
+    }
+    static void setDateTime(const DateTime &dt)
+    {
+        uint8_t buf[RTC_TIME_BLOCK_LEN];
+        RtcCodec<Chip>::encode(dt, buf);
+        writeRegisters(Chip::TIME_REG, buf, sizeof(buf));
+        afterSetTime();
+    }
+    // Set the RTC using timestamp (seconds since epoch)
+    static void setEpoch(uint32_t ts)
+    {
+        setDateTime(DateTime(ts < EPOCH_TIME_OFF ? 0L : (long)(ts - EPOCH_TIME_OFF)));
+    }
+
+    // Implemented per chip below. Return false for settings the chip lacks.
+    static bool setSquareWave(SqwRate_t rate) { return setSquareWave(rate, Chip()); }
+    static bool enableAlarm(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24,
+                            uint8_t minutes, uint8_t seconds)
+    {
+        return enableAlarm(alarmType, daydate, hh24, minutes, seconds, Chip());
+    }
+    static void clearAlarm() { clearAlarm(Chip()); }
+
+    static uint8_t readRegisters(uint8_t reg, uint8_t *buf, uint8_t len)
+    {
+        Bus::beginTransmission(Chip::ADDRESS);
+        Bus::write(reg);
+        Bus::endTransmission();
+        uint8_t sz_read = Bus::requestFrom(Chip::ADDRESS, len);
+        for (uint8_t lp = 0; lp < len; lp++)
+            buf[lp] = Bus::read();
+        return sz_read;
+    }
+    static void writeRegisters(uint8_t reg, const uint8_t *buf, uint8_t len)
+    {
+        Bus::beginTransmission(Chip::ADDRESS);
+        Bus::write(reg);
+        for (uint8_t lp = 0; lp < len; lp++)
+            Bus::write(buf[lp]);
+        Bus::endTransmission();
+    }
+    static uint8_t readRegister(uint8_t reg)
+    {
+        uint8_t value;
+        readRegisters(reg, &value, 1);
+        return value;
+    }
+    static void writeRegister(uint8_t reg, uint8_t value) { writeRegisters(reg, &value, 1); }
+
+private:
+    // The chip traits are empty tags, so the overload is chosen at compile time
+    static void afterSetTime() { afterSetTime(Chip()); }
+    static void afterSetTime(Ds3231Chip) {}
+    static void afterSetTime(Pcf8523Chip);
+    static bool setSquareWave(SqwRate_t rate, Ds3231Chip);
+    static bool setSquareWave(SqwRate_t rate, Pcf8523Chip);
+    static bool enableAlarm(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24,
+                            uint8_t minutes, uint8_t seconds, Ds3231Chip);
+    static bool enableAlarm(ALARM_TYPES_t alarmType, uint8_t daydate, uint8_t hh24,
+                            uint8_t minutes, uint8_t seconds, Pcf8523Chip);
+    static void clearAlarm(Ds3231Chip);
+    static void clearAlarm(Pcf8523Chip);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// DS3231
+
+template <class Chip, class Bus>
+inline bool RtcDriver<Chip, Bus>::setSquareWave(SqwRate_t rate, Ds3231Chip)
+{
+    uint8_t ctReg = readRegister(0x0E);
+    uint8_t stReg = readRegister(0x0F);
+    encodeDs3231SquareWave(rate, ctReg, stReg);
+    writeRegister(0x0E, ctReg);
+    writeRegister(0x0F, stReg | 0b00000011);    // A1F/A2F clear only when written 0
+    return true;
+}
+
+template <class Chip, class Bus>
+inline bool RtcDriver<Chip, Bus>::enableAlarm(ALARM_TYPES_t alarmType, uint8_t daydate,
+                                              uint8_t hh24, uint8_t minutes, uint8_t seconds,
+                                              Ds3231Chip)
+{
+    uint8_t buf[4];
+    encodeDs3231Alarm1(alarmType, daydate, hh24, minutes, seconds, buf);
+    writeRegisters(0x07, buf, sizeof(buf));
+    writeRegister(0x0E, 0b00011101);    // INTCN and A1IE
+    return true;
+}
+
+template <class Chip, class Bus>
+inline void RtcDriver<Chip, Bus>::clearAlarm(Ds3231Chip)
+{
+    writeRegister(0x0F, readRegister(0x0F) & ~0b00000001);     // A1F
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PCF8523
+
+template <class Chip, class Bus>
+inline void RtcDriver<Chip, Bus>::afterSetTime(Pcf8523Chip)
+{
+    // set to battery switchover mode
+    writeRegister(0x02, 0x00);
+}
+
+template <class Chip, class Bus>
+inline bool RtcDriver<Chip, Bus>::setSquareWave(SqwRate_t rate, Pcf8523Chip)
+{
+    // Tmr_CLKOUT_ctrl 0x0F: COF in bits 5:3, see Pcf8523SqwPinMode
+    static const uint8_t cof[] = { 7, 6, 4, 3, 2, 0 };
+    if ((uint8_t)rate >= sizeof(cof))
+        return false;
+    uint8_t reg = readRegister(0x0F) & ~0b00111000;
+    writeRegister(0x0F, reg | (cof[rate] << 3));
+    return true;
+}
+
+// The PCF8523 alarm has no seconds field and fires at second 0
+template <class Chip, class Bus>
+inline bool RtcDriver<Chip, Bus>::enableAlarm(ALARM_TYPES_t alarmType, uint8_t daydate,
+                                              uint8_t hh24, uint8_t minutes, uint8_t seconds,
+                                              Pcf8523Chip)
+{
+    if (alarmType == EVERY_SECOND || alarmType == MATCH_SECONDS || seconds != 0)
+        return false;
+    // Minute, hour, day, weekday alarm registers; bit 7 (AEN) set disables a field
+    uint8_t buf[4] = { bin2bcd(minutes), 0x80, 0x80, 0x80 };
+    if (alarmType != MATCH_MINUTES)
+        buf[1] = bin2bcd(hh24);
+    if (alarmType == MATCH_DATE)
+        buf[2] = bin2bcd(daydate);
+    if (alarmType == MATCH_DAY)
+        buf[3] = daydate;
+    writeRegisters(0x0A, buf, sizeof(buf));
+    writeRegister(0x00, readRegister(0x00) | 0b00000010);     // Control_1 AIE
+    return true;
+}
+
+template <class Chip, class Bus>
+inline void RtcDriver<Chip, Bus>::clearAlarm(Pcf8523Chip)
+{
+    // Control_2 flags clear when written 0 and are left alone when written 1
+    writeRegister(0x01, readRegister(0x01) & ~0b00001000);     // AF
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
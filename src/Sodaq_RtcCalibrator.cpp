@@ -0,0 +1,8 @@
+// Drift estimation and aging offset trim, see Sodaq_RtcCalibrator.h
+
+#include "Sodaq_RtcCalibrator_impl.h"
+
+namespace sodaq_DS3231_nm {
+// The RtcCalibrator on Sodaq_DS3231, compiled once here; see the extern template
+template class RtcCalibratorT<Sodaq_DS3231>;
+} //namespace sodaq_DS3231_nm
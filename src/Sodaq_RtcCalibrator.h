@@ -0,0 +1,72 @@
+// Drift estimation and aging offset trim for the DS3231.
+//
+// Each time the clock is compared with a reference (PC, NTP, GPS), record
+// the pair with addSample() or sample(). estimatePpm() fits a least-squares
+// line through the RTC error over time; its slope is the frequency error.
+// apply() moves the aging offset register to cancel it, so the clock keeps
+// within spec for longer and needs fewer setEpoch() corrections.
+//
+// After apply() the frequency has changed, so the samples are cleared. The
+// RTC still carries whatever time error it had; correct that separately.
+//
+// RtcCalibrator trims Sodaq_DS3231; RtcCalibratorT takes the driver type,
+// e.g. Sodaq_DS3231T<TwoWireBus<Wire1> >, with Sodaq_RtcCalibrator_impl.h.
+
+#ifndef SODAQ_RTCCALIBRATOR_H
+#define SODAQ_RTCCALIBRATOR_H
+
+#include "Sodaq_DS3231.h"
+
+#ifndef SODAQ_CAL_SAMPLES
+#define SODAQ_CAL_SAMPLES   8
+#endif
+// Aging offset sensitivity at 25 deg C, in 1/100 ppm per LSB
+#define DS3231_AGING_LSB_CPPM   10
+
+namespace sodaq_DS3231_nm {
+
+template <class Rtc>
+class RtcCalibratorT {
+public:
+    explicit RtcCalibratorT(Rtc &rtc);
+
+    // Record the RTC reading taken at the same instant as the reference,
+    // both as seconds since 2000 plus milliseconds, and the temperature in
+    // 1/4 deg C. When full, the oldest sample is dropped.
+    void addSample(uint32_t refY2k, uint16_t refMs, uint32_t rtcY2k, uint16_t rtcMs,
+                   int16_t tempQuarters);
+    // Read the RTC (and its last temperature) against a reference time
+    // for this instant, given as seconds since the Unix epoch plus
+    // milliseconds. The RTC is read at its next seconds rollover, which
+    // takes up to a second, so the reading is good to a millisecond or two;
+    // it is then taken back to the time of the call with millis().
+    // Returns false, and records nothing, if the RTC can't be read.
+    bool sample(uint32_t refEpoch, uint16_t refMs);
+
+    // Frequency error in ppm, positive when the RTC runs fast. Needs at
+    // least two samples at least minSpanSecs apart; returns false otherwise.
+    bool estimatePpm(float &ppm, uint32_t minSpanSecs = 86400UL) const;
+    // Adjust the aging offset to cancel the estimated error. Returns false
+    // if there isn't enough data or the register can't be read or written.
+    // The samples are cleared on success.
+    bool apply(uint32_t minSpanSecs = 86400UL);
+
+    uint8_t count() const { return _count; }
+    int16_t meanTemperatureQuarters() const;
+    void clear() { _count = 0; }
+
+private:
+    Rtc &_rtc;
+    uint32_t _refY2k[SODAQ_CAL_SAMPLES];
+    int32_t _errorMs[SODAQ_CAL_SAMPLES];    // RTC minus reference
+    int16_t _temp[SODAQ_CAL_SAMPLES];
+    uint8_t _count;
+    uint8_t _next;
+};
+
+typedef RtcCalibratorT<Sodaq_DS3231> RtcCalibrator;
+// Instantiated in Sodaq_RtcCalibrator.cpp
+extern template class RtcCalibratorT<Sodaq_DS3231>;
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,128 @@
+// RtcCalibratorT member definitions, see Sodaq_RtcCalibrator.h.
+//
+// The library instantiates RtcCalibrator itself. Include this header
+// where it calibrates a driver on another bus.
+
+#ifndef SODAQ_RTCCALIBRATOR_IMPL_H
+#define SODAQ_RTCCALIBRATOR_IMPL_H
+
+#include "Sodaq_RtcCalibrator.h"
+#include "Sodaq_DS3231_impl.h"
+
+namespace sodaq_DS3231_nm {
+
+template <class Rtc>
+RtcCalibratorT<Rtc>::RtcCalibratorT(Rtc &rtc) : _rtc(rtc), _count(0), _next(0)
+{
+}
+
+template <class Rtc>
+void RtcCalibratorT<Rtc>::addSample(uint32_t refY2k, uint16_t refMs, uint32_t rtcY2k, uint16_t rtcMs,
+                              int16_t tempQuarters)
+{
+    _refY2k[_next] = refY2k;
+    _errorMs[_next] = (int32_t)(rtcY2k - refY2k) * 1000L + ((int32_t)rtcMs - refMs);
+    _temp[_next] = tempQuarters;
+    _next = (_next + 1) % SODAQ_CAL_SAMPLES;
+    if (_count < SODAQ_CAL_SAMPLES)
+        _count++;
+}
+
+// Without a rollover to time against, now() is only good to a second,
+// which is as much as a whole day of drift at 10 ppm.
+template <class Rtc>
+bool RtcCalibratorT<Rtc>::sample(uint32_t refEpoch, uint16_t refMs)
+{
+    uint32_t callMs = millis();
+    if (!_rtc.syncClock())
+        return false;
+    // Just after the rollover: to the ms from the cached clock, and within
+    // the poll interval of syncClock() (ms = 0) without it
+    uint16_t rtcMs;
+    uint32_t rtcY2k = _rtc.getEpochMs(rtcMs) - EPOCH_TIME_OFF;
+    uint32_t backMs = millis() - callMs;
+    if (_rtc.lastStatus() != DS3231_OK)
+        return false;
+    int16_t temp = _rtc.getTemperatureQuarters();
+    if (_rtc.lastStatus() != DS3231_OK)
+        return false;
+
+    rtcY2k -= backMs / 1000;
+    backMs %= 1000;
+    if (rtcMs < backMs) {
+        rtcY2k--;
+        rtcMs += 1000;
+    }
+    addSample(refEpoch - EPOCH_TIME_OFF, refMs, rtcY2k, rtcMs - backMs, temp);
+    return true;
+}
+
+// Slope of error against reference time, with both centred on their means
+// first so single precision floats keep enough digits over weeks of data.
+template <class Rtc>
+bool RtcCalibratorT<Rtc>::estimatePpm(float &ppm, uint32_t minSpanSecs) const
+{
+    if (_count < 2)
+        return false;
+    uint32_t t0 = _refY2k[0];
+    uint32_t tMin = 0;
+    uint32_t tMax = 0;
+    float sumT = 0;
+    float sumE = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        int32_t t = (int32_t)(_refY2k[i] - t0);
+        if (i == 0 || t < (int32_t)tMin) tMin = t;
+        if (i == 0 || t > (int32_t)tMax) tMax = t;
+        sumT += t;
+        sumE += _errorMs[i];
+    }
+    if ((int32_t)(tMax - tMin) < (int32_t)minSpanSecs)
+        return false;
+
+    float meanT = sumT / _count;
+    float meanE = sumE / _count;
+    float sxx = 0;
+    float sxy = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        float dt = (int32_t)(_refY2k[i] - t0) - meanT;
+        sxx += dt * dt;
+        sxy += dt * (_errorMs[i] - meanE);
+    }
+    // ms of error per s is 1000 ppm
+    ppm = sxy / sxx * 1000.0f;
+    return true;
+}
+
+template <class Rtc>
+bool RtcCalibratorT<Rtc>::apply(uint32_t minSpanSecs)
+{
+    float ppm;
+    if (!estimatePpm(ppm, minSpanSecs))
+        return false;
+    int16_t step = (int16_t)(ppm * 100.0f / DS3231_AGING_LSB_CPPM + (ppm < 0 ? -0.5f : 0.5f));
+    // A failed read returns 0, which would trim from the wrong base
+    int16_t offset = _rtc.getAgingOffset();
+    if (_rtc.lastStatus() != DS3231_OK)
+        return false;
+    offset += step;
+    if (offset > 127) offset = 127;
+    if (offset < -128) offset = -128;
+    if (_rtc.setAgingOffset((int8_t)offset) != DS3231_OK)
+        return false;
+    clear();
+    return true;
+}
+
+template <class Rtc>
+int16_t RtcCalibratorT<Rtc>::meanTemperatureQuarters() const
+{
+    if (!_count)
+        return 0;
+    int32_t sum = 0;
+    for (uint8_t i = 0; i < _count; i++)
+        sum += _temp[i];
+    return sum / _count;
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,8 @@
+// Sub-second timestamps from the DS3231 1 Hz square wave, see Sodaq_SubSecondClock.h
+
+#include "Sodaq_SubSecondClock_impl.h"
+
+namespace sodaq_DS3231_nm {
+// The SubSecondClock on Sodaq_DS3231, compiled once here; see the extern template
+template class SubSecondClockT<Sodaq_DS3231>;
+} //namespace sodaq_DS3231_nm
@@ -0,0 +1,99 @@
+// Sub-second timestamps from the DS3231 1 Hz square wave.
+//
+// begin() turns on the 1 Hz output on the INT/SQW pin. Attach edge() to
+// its FALLING edge, which is when the seconds register advances:
+//
+//   SubSecondClock ssc(rtcExtPhy);
+//   void sqwIsr() { ssc.edge(); }
+//   ssc.begin();
+//   attachInterrupt(digitalPinToInterrupt(SQW_PIN), sqwIsr, FALLING);
+//
+// Each edge is timestamped with micros(). getEpochUs() returns the RTC
+// second plus the time since its edge, rescaled by the measured rate of
+// micros() against the RTC, so the fraction stays in RTC microseconds
+// whatever the MCU clock error. The RTC is only read once, to name the
+// second of an edge; afterwards edges are counted.
+//
+// The rate is measured over windows of SODAQ_SUBSEC_WINDOW seconds, and
+// getMcuPpm() reports it so other MCU timers can be corrected. A timer
+// input capture can report its edges through edgeAt() instead, with its
+// count converted to microseconds.
+//
+// The SQW pin can't signal alarms while the square wave is on, so this
+// does not combine with enableInterrupts() or AlarmScheduler.
+//
+// SubSecondClockT<Rtc> (Sodaq_SubSecondClock_impl.h) takes a driver on
+// another bus; SubSecondClock is the one on Sodaq_DS3231.
+
+#ifndef SODAQ_SUBSECONDCLOCK_H
+#define SODAQ_SUBSECONDCLOCK_H
+
+#include "Sodaq_DS3231.h"
+
+// Seconds per MCU rate measurement. Longer windows resolve finer (micros()
+// has a 4 us step on a 16 MHz AVR, 0.06 ppm over 64 s) but follow
+// temperature changes of the MCU oscillator more slowly.
+#ifndef SODAQ_SUBSEC_WINDOW
+#define SODAQ_SUBSEC_WINDOW 64
+#endif
+
+namespace sodaq_DS3231_nm {
+
+template <class Rtc>
+class SubSecondClockT {
+public:
+    explicit SubSecondClockT(Rtc &rtc);
+
+    // Enable the 1 Hz square wave and forget the previous edges
+    void begin();
+    // Call from the SQW falling edge interrupt
+    void edge() { edgeAt(micros()); }
+    void edgeAt(uint32_t us);
+
+    // Seconds since the Unix epoch, with the microsecond fraction in us.
+    // Until the first edges have been seen this reads the RTC, with us 0.
+    uint32_t getEpochUs(uint32_t &us);
+    // As getEpochUs(), at a micros() value captured earlier, e.g. in an
+    // event's interrupt handler. It must be after the latest edge.
+    uint32_t getEpochUsAt(uint32_t timeUs, uint32_t &us);
+    // True once an edge has been matched to an RTC second
+    bool synced() const { return _anchored; }
+    // Forget the RTC second, e.g. after setting the RTC
+    void resync() { _anchored = false; }
+
+    // MCU clock error against the RTC in ppm, positive when micros() runs
+    // fast. Valid once a full window has passed, 0 before.
+    float getMcuPpm();
+    bool mcuPpmValid() const { return _rateValid; }
+    uint32_t edges() const;
+
+private:
+    void update();
+
+    Rtc &_rtc;
+
+    // Written by the edge interrupt
+    volatile uint32_t _edgeUs;      // micros() at the latest edge
+    volatile uint32_t _edgeCount;
+    volatile uint32_t _windowUs;    // micros() at the start of the window
+    volatile uint32_t _windowStart; // _edgeCount at the start of the window
+    volatile uint32_t _spanUs;      // Length of the last full window
+    volatile uint16_t _spanSecs;
+    volatile bool _spanReady;
+
+    bool _anchored;
+    uint32_t _failedCount;          // Edge whose RTC read failed, 0 if none
+    uint32_t _anchorEpoch;          // RTC second that began at edge _anchorCount
+    uint32_t _anchorCount;
+    bool _rateValid;
+    uint32_t _periodUs;             // micros() ticks per RTC second
+    float _scale;                   // RTC microseconds per micros() tick
+    float _ppm;
+};
+
+typedef SubSecondClockT<Sodaq_DS3231> SubSecondClock;
+// Instantiated in Sodaq_SubSecondClock.cpp
+extern template class SubSecondClockT<Sodaq_DS3231>;
+
+} //namespace sodaq_DS3231_nm
+#endif
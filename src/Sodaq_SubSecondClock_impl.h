@@ -0,0 +1,160 @@
+// SubSecondClockT member definitions, see Sodaq_SubSecondClock.h.
+//
+// The library instantiates SubSecondClock itself. Include this header
+// where the clock reads a driver on another bus.
+
+#ifndef SODAQ_SUBSECONDCLOCK_IMPL_H
+#define SODAQ_SUBSECONDCLOCK_IMPL_H
+
+#include "Sodaq_SubSecondClock.h"
+#include "Sodaq_DS3231_impl.h"
+
+namespace sodaq_DS3231_nm {
+
+#if SODAQ_SUBSEC_WINDOW > 4000
+#error "SODAQ_SUBSEC_WINDOW must be shorter than the 4294 s micros() period"
+#endif
+
+// A window further off than this is taken to have lost or gained an edge
+#define SODAQ_SUBSEC_MAX_PPM    20000L
+
+template <class Rtc>
+SubSecondClockT<Rtc>::SubSecondClockT(Rtc &rtc) : _rtc(rtc),
+    _edgeUs(0), _edgeCount(0), _windowUs(0), _windowStart(0),
+    _spanUs(0), _spanSecs(0), _spanReady(false),
+    _anchored(false), _failedCount(0), _anchorEpoch(0), _anchorCount(0),
+    _rateValid(false), _periodUs(1000000UL), _scale(1.0f), _ppm(0)
+{
+}
+
+template <class Rtc>
+void SubSecondClockT<Rtc>::begin()
+{
+    noInterrupts();
+    _edgeCount = 0;
+    _spanReady = false;
+    interrupts();
+    _anchored = false;
+    _failedCount = 0;
+    _rtc.setSquareWave(SQW_1HZ);
+}
+
+template <class Rtc>
+void SubSecondClockT<Rtc>::edgeAt(uint32_t us)
+{
+    uint32_t count = _edgeCount + 1;
+    uint32_t gap = us - _edgeUs;
+    if (count == 1 || gap > 1500000UL) {
+        // First edge, or edges were lost (interrupts off too long): count
+        // the whole seconds in the gap and restart the rate measurement
+        if (count > 1)
+            count += (gap - 500000UL) / 1000000UL;
+        _windowUs = us;
+        _windowStart = count;
+    } else if (count - _windowStart >= SODAQ_SUBSEC_WINDOW) {
+        _spanUs = us - _windowUs;
+        _spanSecs = count - _windowStart;
+        _spanReady = true;
+        _windowUs = us;
+        _windowStart = count;
+    }
+    _edgeUs = us;
+    _edgeCount = count;
+}
+
+// Turn a finished window into the rate, outside the interrupt handler
+template <class Rtc>
+void SubSecondClockT<Rtc>::update()
+{
+    noInterrupts();
+    bool ready = _spanReady;
+    uint32_t spanUs = _spanUs;
+    uint16_t spanSecs = _spanSecs;
+    _spanReady = false;
+    interrupts();
+    if (!ready)
+        return;
+
+    int32_t errUs = (int32_t)(spanUs - spanSecs * 1000000UL);
+    if ((errUs < 0 ? -errUs : errUs) > spanSecs * SODAQ_SUBSEC_MAX_PPM)
+        return;
+    _ppm = (float)errUs / spanSecs;
+    _scale = (float)spanSecs * 1000000.0f / spanUs;
+    _periodUs = spanUs / spanSecs;
+    _rateValid = true;
+}
+
+template <class Rtc>
+uint32_t SubSecondClockT<Rtc>::getEpochUs(uint32_t &us)
+{
+    return getEpochUsAt(micros(), us);
+}
+
+template <class Rtc>
+uint32_t SubSecondClockT<Rtc>::getEpochUsAt(uint32_t timeUs, uint32_t &us)
+{
+    update();
+
+    noInterrupts();
+    uint32_t edgeUs = _edgeUs;
+    uint32_t count = _edgeCount;
+    interrupts();
+
+    if (!_anchored && count > 0 && count != _failedCount && micros() - edgeUs < 900000UL) {
+        // Name the second that began at the latest edge. If another edge
+        // came during the read, the value may belong to either; try later.
+        // A failed read is tried again on the next edge.
+        uint32_t epoch = _rtc.readNow().getEpoch();
+        noInterrupts();
+        bool sameEdge = _edgeCount == count;
+        interrupts();
+        if (_rtc.lastStatus() != DS3231_OK) {
+            _failedCount = count;
+        } else if (sameEdge) {
+            _anchorEpoch = epoch;
+            _anchorCount = count;
+            _anchored = true;
+        }
+    }
+    if (!_anchored) {
+        us = 0;
+        return _rtc.now().getEpoch();
+    }
+
+    uint32_t secs = count - _anchorCount;
+    uint32_t elapsed = timeUs - edgeUs;
+    if ((int32_t)elapsed < 0 && secs > 0) {
+        // Captured before the latest edge, time it from the one before
+        secs--;
+        elapsed += _periodUs;
+    }
+    uint32_t frac = _rateValid ? (uint32_t)(elapsed * _scale) : elapsed;
+    if (frac >= 1000000UL) {
+        // No edge for over a second; extrapolate
+        secs += frac / 1000000UL;
+        frac %= 1000000UL;
+    }
+    us = frac;
+    return _anchorEpoch + secs;
+}
+
+// A 32-bit read takes several instructions on AVR, so copy it with the
+// edge interrupt held off
+template <class Rtc>
+uint32_t SubSecondClockT<Rtc>::edges() const
+{
+    noInterrupts();
+    uint32_t count = _edgeCount;
+    interrupts();
+    return count;
+}
+
+template <class Rtc>
+float SubSecondClockT<Rtc>::getMcuPpm()
+{
+    update();
+    return _ppm;
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
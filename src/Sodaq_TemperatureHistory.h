@@ -0,0 +1,118 @@
+// Fixed size history of DS3231 temperature samples with running statistics.
+//
+// Samples are kept as 1/4 deg C (Sodaq_DS3231::getTemperatureQuarters())
+// with a y2k seconds timestamp in a ring of N entries, 6 bytes each on AVR
+// (8 where a uint32_t is 4-byte aligned).
+// Mean, minimum and maximum over the samples in the ring are maintained
+// as samples arrive: the mean from a running sum, the extremes with
+// monotonic queues, so add() is amortised O(1) and every query is O(1).
+// No floating point is involved.
+
+#ifndef SODAQ_TEMPERATUREHISTORY_H
+#define SODAQ_TEMPERATUREHISTORY_H
+
+#include "Sodaq_DS3231.h"
+
+// The temperature of the sample that newest(), minimum() and maximum()
+// return while the history is empty; the DS3231 reads -128..127.75 deg C
+#define TEMP_HISTORY_NO_SAMPLE  (-32767 - 1)
+
+namespace sodaq_DS3231_nm {
+
+template <uint8_t N>
+class TemperatureHistory {
+public:
+    struct Sample {
+        uint32_t y2k;           // seconds since 2000
+        int16_t quarters;       // 1/4 deg C
+    };
+
+    TemperatureHistory() { clear(); }
+
+    void clear()
+    {
+        _count = 0;
+        _next = 0;
+        _sum = 0;
+        _minHead = _minSize = 0;
+        _maxHead = _maxSize = 0;
+    }
+
+    void add(uint32_t y2k, int16_t quarters)
+    {
+        if (_count == N) {
+            // Slot _next holds the oldest sample, which leaves the window
+            _sum -= _ring[_next].quarters;
+            if (_minSize && _minQ[_minHead] == _next) popFront(_minHead, _minSize);
+            if (_maxSize && _maxQ[_maxHead] == _next) popFront(_maxHead, _maxSize);
+        } else {
+            _count++;
+        }
+        _ring[_next].y2k = y2k;
+        _ring[_next].quarters = quarters;
+        _sum += quarters;
+
+        while (_minSize && _ring[back(_minQ, _minHead, _minSize)].quarters >= quarters)
+            _minSize--;
+        _minQ[(_minHead + _minSize++) % N] = _next;
+        while (_maxSize && _ring[back(_maxQ, _maxHead, _maxSize)].quarters <= quarters)
+            _maxSize--;
+        _maxQ[(_maxHead + _maxSize++) % N] = _next;
+
+        _next = (_next + 1) % N;
+    }
+
+    // Read the temperature and time from the RTC, two bus transactions or
+    // none when the register cache and cached clock are in use. Returns
+    // false, and adds nothing, if either read failed. Any Sodaq_DS3231T
+    // will do.
+    template <class Rtc>
+    bool sample(Rtc &rtc)
+    {
+        int16_t quarters = rtc.getTemperatureQuarters();
+        if (rtc.lastStatus() != DS3231_OK)
+            return false;
+        uint32_t y2k = rtc.now().get();
+        if (rtc.lastStatus() != DS3231_OK)
+            return false;
+        add(y2k, quarters);
+        return true;
+    }
+
+    uint8_t count() const { return _count; }
+    // i = 0 is the oldest sample, count() - 1 the newest
+    const Sample &at(uint8_t i) const { return _ring[(_next + N - _count + i) % N]; }
+    // With no samples these return y2k 0 and TEMP_HISTORY_NO_SAMPLE
+    const Sample &newest() const { return _count ? at(_count - 1) : _none; }
+    const Sample &minimum() const { return _count ? _ring[_minQ[_minHead]] : _none; }
+    const Sample &maximum() const { return _count ? _ring[_maxQ[_maxHead]] : _none; }
+    // Mean in 1/4 deg C, rounded towards zero
+    int16_t meanQuarters() const { return _count ? _sum / _count : 0; }
+
+private:
+    static void popFront(uint8_t &head, uint8_t &size)
+    {
+        head = (head + 1) % N;
+        size--;
+    }
+    static uint8_t back(const uint8_t *q, uint8_t head, uint8_t size)
+    {
+        return q[(head + size - 1) % N];
+    }
+
+    static const Sample _none;
+    Sample _ring[N];
+    uint8_t _minQ[N];       // Slots with increasing temperatures
+    uint8_t _maxQ[N];       // Slots with decreasing temperatures
+    int32_t _sum;
+    uint8_t _count;
+    uint8_t _next;
+    uint8_t _minHead, _minSize;
+    uint8_t _maxHead, _maxSize;
+};
+
+template <uint8_t N>
+const typename TemperatureHistory<N>::Sample TemperatureHistory<N>::_none = { 0, TEMP_HISTORY_NO_SAMPLE };
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,8 @@
+// Framed binary time sync with a host, see Sodaq_TimeSync.h
+
+#include "Sodaq_TimeSync_impl.h"
+
+namespace sodaq_DS3231_nm {
+// The TimeSyncResponder on Sodaq_DS3231, compiled once here; see the extern template
+template class TimeSyncResponderT<Sodaq_DS3231>;
+} //namespace sodaq_DS3231_nm
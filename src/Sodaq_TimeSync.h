@@ -0,0 +1,92 @@
+// Framed binary time sync with a host, NTP style.
+//
+// The host sends requests over a serial port and the device answers from
+// poll(). Device timestamps are micros(), so the host can work out the
+// offset and rate of micros() against its own clock to well below a
+// millisecond from the four timestamps of each exchange. It then asks
+// the device to write the RTC at the micros() value where host time
+// reaches a whole second. Writing the seconds register restarts the
+// DS3231 countdown, so the RTC second starts right there.
+//
+// Frame: TSYNC_SOF, type, payload length, payload, then a CRC-16/CCITT
+// (poly 0x1021, init 0xFFFF) over type, length and payload, high byte
+// first. Fields are little endian. All requests and replies carry
+// TSYNC_PAYLOAD_LEN bytes, so both directions spend equal time on the wire:
+//
+//   PING 0x01 { t1 u64 host us, 8 pad }      PONG 0x81 { t1 u64, t2 u32, t3 u32 }
+//   SET  0x02 { epoch i64, at u32, 4 pad }   SET  0x82 { old epoch i64, written u32, status u8, 3 pad }
+//   READ 0x03 { 16 pad }                     READ 0x83 { epoch i64, rollover u32, 4 pad }
+//
+// t2 is micros() when the request was complete, t3 just before the reply.
+// SET writes epoch when micros() reaches at (at most 3 s ahead). READ
+// waits for the next RTC second and returns it with the micros() at which
+// it began, to +-0.5 ms, so the host can check the result.
+//
+// poll() drops any byte that doesn't start or continue a frame. Text
+// commands can share the port if the sketch reads them before calling
+// poll(), whenever peek() isn't TSYNC_SOF, as PCsync.ino does. The host
+// tool is examples/PCsync/python3.9/PCsyncBinary.py.
+//
+// TimeSyncResponder sets Sodaq_DS3231. To set a driver on another bus,
+// include Sodaq_TimeSync_impl.h and use TimeSyncResponderT<its type>.
+
+#ifndef SODAQ_TIMESYNC_H
+#define SODAQ_TIMESYNC_H
+
+#include "Sodaq_DS3231.h"
+
+#define TSYNC_SOF           0xA5
+#define TSYNC_PAYLOAD_LEN   16
+#define TSYNC_FRAME_LEN     (3 + TSYNC_PAYLOAD_LEN + 2)
+// A frame must arrive within this time, or its start is dropped
+#define TSYNC_FRAME_MS      100
+
+namespace sodaq_DS3231_nm {
+
+enum TimeSyncType_t {
+    TSYNC_PING = 0x01,
+    TSYNC_SET = 0x02,
+    TSYNC_READ = 0x03,
+    TSYNC_REPLY = 0x80,     // Or'ed into the request type
+};
+
+enum TimeSyncStatus_t {
+    TSYNC_OK = 0,
+    TSYNC_LATE = 1,         // at had already passed
+    TSYNC_TOO_FAR = 2,      // at was more than 3 s ahead
+};
+
+template <class Rtc>
+class TimeSyncResponderT {
+public:
+    TimeSyncResponderT(Rtc &rtc, Stream &port);
+
+    // Read the bytes waiting on the port and answer a complete request.
+    // Returns the request type answered, or 0, also for a frame of an
+    // unknown type, which gets no reply. SET and READ block for up to 3 s
+    // and 1 s.
+    uint8_t poll();
+
+    static uint16_t crc16(const uint8_t *buf, uint8_t len);
+
+private:
+    bool answer(uint32_t t2);
+    void reply(uint8_t type, const uint8_t *payload);
+    static void put32(uint8_t *p, uint32_t v);
+    static uint32_t get32(const uint8_t *p);
+    static void put64(uint8_t *p, uint64_t v);
+    static uint64_t get64(const uint8_t *p);
+
+    Rtc &_rtc;
+    Stream &_port;
+    uint8_t _rx[TSYNC_FRAME_LEN];
+    uint8_t _rxLen;
+    uint32_t _rxMs;         // millis() at the start of the frame
+};
+
+typedef TimeSyncResponderT<Sodaq_DS3231> TimeSyncResponder;
+// Instantiated in Sodaq_TimeSync.cpp
+extern template class TimeSyncResponderT<Sodaq_DS3231>;
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,171 @@
+// TimeSyncResponderT member definitions, see Sodaq_TimeSync.h.
+//
+// The library instantiates TimeSyncResponder itself. Include this header
+// where the responder sets a driver on another bus.
+
+#ifndef SODAQ_TIMESYNC_IMPL_H
+#define SODAQ_TIMESYNC_IMPL_H
+
+#include "Sodaq_TimeSync.h"
+#include "Sodaq_DS3231_impl.h"
+
+namespace sodaq_DS3231_nm {
+
+// SET refuses a write time further ahead than this
+#define TSYNC_SET_MAX_US    3000000L
+// READ gives up when the RTC second doesn't change for this long
+#define TSYNC_READ_MAX_MS   1100
+
+template <class Rtc>
+void TimeSyncResponderT<Rtc>::put32(uint8_t *p, uint32_t v)
+{
+    for (uint8_t i = 0; i < 4; i++, v >>= 8)
+        p[i] = (uint8_t)v;
+}
+
+template <class Rtc>
+uint32_t TimeSyncResponderT<Rtc>::get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+template <class Rtc>
+void TimeSyncResponderT<Rtc>::put64(uint8_t *p, uint64_t v)
+{
+    put32(p, (uint32_t)v);
+    put32(p + 4, (uint32_t)(v >> 32));
+}
+
+template <class Rtc>
+uint64_t TimeSyncResponderT<Rtc>::get64(const uint8_t *p)
+{
+    return get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+template <class Rtc>
+TimeSyncResponderT<Rtc>::TimeSyncResponderT(Rtc &rtc, Stream &port)
+    : _rtc(rtc), _port(port), _rxLen(0), _rxMs(0)
+{
+}
+
+// CRC-16/CCITT-FALSE, as Python's binascii.crc_hqx(data, 0xFFFF)
+template <class Rtc>
+uint16_t TimeSyncResponderT<Rtc>::crc16(const uint8_t *buf, uint8_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)*buf++ << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+template <class Rtc>
+uint8_t TimeSyncResponderT<Rtc>::poll()
+{
+    if (_rxLen && millis() - _rxMs > TSYNC_FRAME_MS)
+        _rxLen = 0;     // Stale partial frame
+
+    while (_port.available() > 0) {
+        if (_rxLen == 0) {
+            // Drop anything that isn't a frame, or a sketch that doesn't
+            // read it would stall the sync for good
+            if (_port.peek() != TSYNC_SOF) {
+                _port.read();
+                continue;
+            }
+            _rxMs = millis();
+        }
+        _rx[_rxLen++] = _port.read();
+        if (_rxLen == 3 && _rx[2] != TSYNC_PAYLOAD_LEN) {
+            _rxLen = 0;
+            continue;
+        }
+        if (_rxLen == TSYNC_FRAME_LEN) {
+            uint32_t t2 = micros();
+            _rxLen = 0;
+            uint16_t crc = crc16(&_rx[1], 2 + TSYNC_PAYLOAD_LEN);
+            if (_rx[TSYNC_FRAME_LEN - 2] != (uint8_t)(crc >> 8)
+                    || _rx[TSYNC_FRAME_LEN - 1] != (uint8_t)crc)
+                return 0;
+            return answer(t2) ? _rx[1] : 0;
+        }
+    }
+    return 0;
+}
+
+template <class Rtc>
+bool TimeSyncResponderT<Rtc>::answer(uint32_t t2)
+{
+    const uint8_t *req = &_rx[3];
+    uint8_t out[TSYNC_PAYLOAD_LEN];
+    memset(out, 0, sizeof(out));
+
+    switch (_rx[1]) {
+    case TSYNC_PING:
+        memcpy(out, req, 8);
+        put32(&out[8], t2);
+        put32(&out[12], micros());
+        break;
+
+    case TSYNC_SET: {
+        uint32_t at = get32(&req[8]);
+        put64(out, _rtc.readNow().getEpoch64());
+        int32_t wait = (int32_t)(at - micros());
+        if (wait < 0) {
+            out[12] = TSYNC_LATE;
+        } else if (wait > TSYNC_SET_MAX_US) {
+            out[12] = TSYNC_TOO_FAR;
+        } else {
+            DateTime dt = DateTime::fromEpoch64((epoch64_t)get64(req));
+            while ((int32_t)(at - micros()) > 0)
+                ;
+            put32(&out[8], micros());
+            _rtc.setDateTime(dt);
+        }
+        break;
+    }
+
+    case TSYNC_READ: {
+        // The DS3231 latches the time at the START of a read, so the second
+        // began between the starts of the last two reads
+        uint32_t first = _rtc.readNow().get();
+        uint32_t prevUs = micros();
+        uint32_t startMs = millis();
+        while (millis() - startMs < TSYNC_READ_MAX_MS) {
+            uint32_t us = micros();
+            DateTime dt = _rtc.readNow();
+            if (dt.get() != first) {
+                put64(out, dt.getEpoch64());
+                put32(&out[8], prevUs + (us - prevUs) / 2);
+                break;
+            }
+            prevUs = us;
+        }
+        break;
+    }
+
+    default:
+        return false;
+    }
+    reply(_rx[1] | TSYNC_REPLY, out);
+    return true;
+}
+
+template <class Rtc>
+void TimeSyncResponderT<Rtc>::reply(uint8_t type, const uint8_t *payload)
+{
+    uint8_t frame[TSYNC_FRAME_LEN];
+    frame[0] = TSYNC_SOF;
+    frame[1] = type;
+    frame[2] = TSYNC_PAYLOAD_LEN;
+    memcpy(&frame[3], payload, TSYNC_PAYLOAD_LEN);
+    uint16_t crc = crc16(&frame[1], 2 + TSYNC_PAYLOAD_LEN);
+    frame[TSYNC_FRAME_LEN - 2] = crc >> 8;
+    frame[TSYNC_FRAME_LEN - 1] = crc;
+    _port.write(frame, sizeof(frame));
+}
+
+} //namespace sodaq_DS3231_nm
+#endif
@@ -0,0 +1,113 @@
+// Compact binary timestamp stream for data logs, see Sodaq_TimestampCodec.h
+
+#include "Sodaq_TimestampCodec.h"
+
+using namespace sodaq_DS3231_nm;
+
+////////////////////////////////////////////////////////////////////////////////
+// TimestampEncoder implementation
+
+TimestampEncoder::TimestampEncoder(uint16_t keyframeInterval)
+    : _last(0), _interval(keyframeInterval ? keyframeInterval : 1),
+      _sinceKey(0), _started(false)
+{
+}
+
+uint8_t TimestampEncoder::encode(uint32_t y2k, uint8_t *out)
+{
+    uint32_t delta = y2k - _last;
+    if (!_started || y2k < _last || delta > TS_CODEC_MAX_DELTA
+            || _sinceKey + 1 >= _interval) {
+        out[0] = TS_CODEC_KEYFRAME;
+        out[1] = y2k;
+        out[2] = y2k >> 8;
+        out[3] = y2k >> 16;
+        out[4] = y2k >> 24;
+        _last = y2k;
+        _sinceKey = 0;
+        _started = true;
+        return 5;
+    }
+
+    // delta + 1 is never 0, so the first byte can't look like a keyframe
+    uint32_t v = delta + 1;
+    uint8_t len = 0;
+    while (v >= 0x80) {
+        out[len++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    out[len++] = v;
+    _last = y2k;
+    _sinceKey++;
+    return len;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TimestampDecoder implementation
+
+uint8_t TimestampDecoder::decode(const uint8_t *in, size_t len, uint32_t &y2k)
+{
+    if (len == 0)
+        return 0;
+    if (in[0] == TS_CODEC_KEYFRAME) {
+        if (len < 5)
+            return 0;
+        _last = (uint32_t)in[1] | ((uint32_t)in[2] << 8)
+              | ((uint32_t)in[3] << 16) | ((uint32_t)in[4] << 24);
+        _synced = true;
+        y2k = _last;
+        return 5;
+    }
+    if (!_synced)
+        return 0;
+
+    uint32_t v = 0;
+    uint8_t shift = 0;
+    uint8_t pos = 0;
+    for (;;) {
+        if (pos >= len || pos >= 3)
+            return 0;
+        uint8_t b = in[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            break;
+        shift += 7;
+    }
+    _last += v - 1;
+    y2k = _last;
+    return pos;
+}
+
+size_t TimestampDecoder::decodeAll(const uint8_t *in, size_t len, uint32_t *out, size_t maxOut)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    uint32_t last = _last;
+    bool synced = _synced;
+
+    while (pos < len && count < maxOut) {
+        uint8_t b = in[pos];
+        if (b & 0x80 || b == TS_CODEC_KEYFRAME) {
+            // Keyframe or multi-byte delta, take the general path
+            _last = last;
+            _synced = synced;
+            uint8_t used = decode(in + pos, len - pos, out[count]);
+            if (!used)
+                break;
+            last = _last;
+            synced = _synced;
+            pos += used;
+            count++;
+        } else {
+            // Single byte delta, the common case for a fixed sample period
+            if (!synced)
+                break;
+            last += b - 1;
+            out[count++] = last;
+            pos++;
+        }
+    }
+    _last = last;
+    _synced = synced;
+    return count;
+}
@@ -0,0 +1,70 @@
+// Compact binary timestamp stream for data logs.
+//
+// A full text timestamp (DateTime::addToString()) costs 19 bytes per record.
+// TimestampEncoder writes each timestamp, as seconds since 2000
+// (DateTime::getY2k_secs()), either as a keyframe or as a delta:
+//
+//   keyframe  0x00, then the 32-bit y2k seconds, little endian   (5 bytes)
+//   delta     (seconds since the previous timestamp + 1) as an
+//             unsigned LEB128 varint of 1..3 bytes, never starting with 0x00
+//
+// A keyframe is written for the first timestamp, every keyframeInterval
+// timestamps, when the time steps backwards or jumps by more than
+// TS_CODEC_MAX_DELTA, and after forceKeyframe(). Decoding may start at any
+// keyframe, so aligning keyframes with file or block boundaries gives
+// random access.
+//
+// The codec only depends on <stdint.h> and builds unchanged on a host for
+// post-processing logs; extras/tsdecode.py decodes a stream in Python.
+
+#ifndef SODAQ_TIMESTAMPCODEC_H
+#define SODAQ_TIMESTAMPCODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sodaq_DS3231_nm {
+
+#define TS_CODEC_KEYFRAME   0x00
+#define TS_CODEC_MAX_LEN    5           // Longest encoding, a keyframe
+#define TS_CODEC_MAX_DELTA  0x1FFFFEUL  // Largest delta held by a 3 byte varint
+
+class TimestampEncoder {
+public:
+    explicit TimestampEncoder(uint16_t keyframeInterval = 256);
+
+    // Encode y2k seconds into out, which must hold TS_CODEC_MAX_LEN bytes.
+    // Returns the number of bytes written.
+    uint8_t encode(uint32_t y2k, uint8_t *out);
+    // Make the next timestamp a keyframe, e.g. at the start of a new file
+    void forceKeyframe() { _started = false; }
+    // True if the last encode() wrote a keyframe
+    bool lastWasKeyframe() const { return _sinceKey == 0; }
+
+private:
+    uint32_t _last;
+    uint16_t _interval;
+    uint16_t _sinceKey;
+    bool _started;
+};
+
+class TimestampDecoder {
+public:
+    TimestampDecoder() : _last(0), _synced(false) {}
+
+    // Decode one timestamp from in[0..len). Returns the bytes consumed, or 0
+    // if the input is truncated or a delta arrives before any keyframe.
+    uint8_t decode(const uint8_t *in, size_t len, uint32_t &y2k);
+    // Decode a stream that holds only timestamps into out[0..maxOut).
+    // Returns the number of timestamps decoded.
+    size_t decodeAll(const uint8_t *in, size_t len, uint32_t *out, size_t maxOut);
+    // Forget the previous timestamp, e.g. before seeking to a keyframe
+    void reset() { _synced = false; }
+
+private:
+    uint32_t _last;
+    bool _synced;
+};
+
+} //namespace sodaq_DS3231_nm
+#endif